@@ -40,6 +40,8 @@ TARGET_HAS_LEGACY_CAMERA_HAL1 := true
 TARGET_NEEDS_PLATFORM_TEXT_RELOCATIONS := true
 TARGET_PROVIDES_CAMERA_HAL := true
 USE_DEVICE_SPECIFIC_CAMERA := true
+# Parameter fixup variants on top of the common ones, e.g. DERP2 PREVIEW_SIZE
+TARGET_CAMERA_FIXUPS ?=
 
 # Charger
 BOARD_BATTERY_DEVICE_NAME := "battery"
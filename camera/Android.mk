@@ -3,19 +3,25 @@ ifeq ($(TARGET_PROVIDES_CAMERA_HAL),true)
 LOCAL_PATH := $(call my-dir)
 include $(CLEAR_VARS)
 
+# Parameter fixup variants, see CameraFixups.h
+camera_fixups := $(TARGET_CAMERA_FIXUPS)
+
 ifeq ($(TARGET_IS_DERP2),true)
-    LOCAL_CFLAGS += -DDERP2
+    camera_fixups += DERP2
 endif
 
 ifeq ($(TARGET_NEED_PREVIEW_SIZE_FIXUP),true)
-    LOCAL_CFLAGS += -DPREVIEW_SIZE_FIXUP
+    camera_fixups += PREVIEW_SIZE
 endif
 
+LOCAL_CFLAGS += \
+    -DCAMERA_FIXUP_VARIANTS="$(subst $(space),|,$(foreach v,COMMON $(sort $(camera_fixups)),FIXUP_VARIANT_$(v)))"
+
 LOCAL_SRC_FILES := \
     CameraWrapper.cpp
 
 LOCAL_SHARED_LIBRARIES := \
-    libhardware liblog libcamera_client libutils
+    libhardware liblog libcamera_client libutils libcutils
 
 LOCAL_C_INCLUDES += \
     system/media/camera/include
@@ -26,4 +32,6 @@ LOCAL_MODULE_TAGS := optional
 
 include $(BUILD_SHARED_LIBRARY)
 
+include $(call all-makefiles-under,$(LOCAL_PATH))
+
 endif
@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAMERA_FIXUPS_H
+#define CAMERA_FIXUPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Parameter fixups are described by rules grouped into variants. Every
+ * board gets FIXUP_VARIANT_COMMON, the others are picked with
+ * TARGET_CAMERA_FIXUPS in the board config, which camera/Android.mk turns
+ * into CAMERA_FIXUP_VARIANTS. Supporting a new device means adding a
+ * variant and its rules here, not new code in the wrapper.
+ */
+enum {
+    FIXUP_VARIANT_COMMON = 1 << 0,
+    /* APEXQ/EXPRESS */
+    FIXUP_VARIANT_DERP2 = 1 << 1,
+    FIXUP_VARIANT_PREVIEW_SIZE = 1 << 2,
+};
+
+#ifndef CAMERA_FIXUP_VARIANTS
+#define CAMERA_FIXUP_VARIANTS FIXUP_VARIANT_COMMON
+#endif
+
+static constexpr unsigned kFixupVariants =
+        FIXUP_VARIANT_COMMON | (CAMERA_FIXUP_VARIANTS);
+
+/*
+ * DERP2 sensors crash on cancel_auto_focus, so it is only forwarded, as a
+ * vendor command, while in continuous focus mode.
+ */
+static constexpr bool kTrackContinuousFocus =
+        kFixupVariants & FIXUP_VARIANT_DERP2;
+
+/*
+ * Every key a rule can look at or change. The names are those of the
+ * matching CameraParameters::KEY_* constants, which can't be used in
+ * constant expressions.
+ */
+enum param_key {
+    PARAM_ISO_MODE = 0,
+    PARAM_SUPPORTED_ISO_MODES,
+    PARAM_RECORDING_HINT,
+    PARAM_ZSL,
+    PARAM_SAMSUNG_CAMERA_MODE,
+    PARAM_FOCUS_MODE,
+    PARAM_SUPPORTED_PREVIEW_SIZES,
+    PARAM_PREFERRED_PREVIEW_SIZE_FOR_VIDEO,
+    PARAM_EXPOSURE_COMPENSATION_STEP,
+    PARAM_MIN_EXPOSURE_COMPENSATION,
+    PARAM_MAX_EXPOSURE_COMPENSATION,
+    PARAM_VIDEO_SNAPSHOT_SUPPORTED,
+    PARAM_MAX_NUM_DETECTED_FACES_HW,
+    PARAM_MAX_NUM_DETECTED_FACES_SW,
+    PARAM_FACE_DETECTION,
+    PARAM_SUPPORTED_FACE_DETECTION,
+    PARAM_KEY_MAX
+};
+
+static constexpr const char *param_keys[PARAM_KEY_MAX] = {
+    "iso",
+    "iso-values",
+    "recording-hint",
+    "zsl",
+    "cam_mode",
+    "focus-mode",
+    "preview-size-values",
+    "preferred-preview-size-for-video",
+    "exposure-compensation-step",
+    "min-exposure-compensation",
+    "max-exposure-compensation",
+    "video-snapshot-supported",
+    "max-num-detected-faces-hw",
+    "max-num-detected-faces-sw",
+    "face-detection",
+    "face-detection-values",
+};
+
+#define BACK_CAMERA_ID 0
+#define FRONT_CAMERA_ID 1
+
+enum fixup_direction {
+    /* Parameters reported to the framework */
+    FIXUP_GET = 0,
+    /* Parameters handed to the vendor HAL */
+    FIXUP_SET,
+};
+
+#define FIXUP_ANY_CAMERA (-1)
+
+/*
+ * When key has the value match (or always, when match is NULL), set target
+ * to value. Rules are applied in table order, so a later rule for the same
+ * target wins.
+ */
+typedef struct fixup_rule {
+    unsigned variants;
+    int camera_id;
+    enum fixup_direction direction;
+    enum param_key key;
+    const char *match;
+    enum param_key target;
+    const char *value;
+} fixup_rule_t;
+
+#define FIXUP_ALWAYS(variants, camera_id, direction, target, value) \
+    { variants, camera_id, direction, target, NULL, target, value }
+#define FIXUP_WHEN(variants, camera_id, direction, key, match, target, value) \
+    { variants, camera_id, direction, key, match, target, value }
+
+static constexpr fixup_rule_t all_fixup_rules[] = {
+    /* Map the corrected ISO values to the ones in the HAL */
+    FIXUP_WHEN(FIXUP_VARIANT_COMMON, FIXUP_ANY_CAMERA, FIXUP_SET,
+            PARAM_ISO_MODE, "ISO100", PARAM_ISO_MODE, "100"),
+    FIXUP_WHEN(FIXUP_VARIANT_COMMON, FIXUP_ANY_CAMERA, FIXUP_SET,
+            PARAM_ISO_MODE, "ISO200", PARAM_ISO_MODE, "200"),
+    FIXUP_WHEN(FIXUP_VARIANT_COMMON, FIXUP_ANY_CAMERA, FIXUP_SET,
+            PARAM_ISO_MODE, "ISO400", PARAM_ISO_MODE, "400"),
+    FIXUP_WHEN(FIXUP_VARIANT_COMMON, FIXUP_ANY_CAMERA, FIXUP_SET,
+            PARAM_ISO_MODE, "ISO800", PARAM_ISO_MODE, "800"),
+    FIXUP_WHEN(FIXUP_VARIANT_COMMON, FIXUP_ANY_CAMERA, FIXUP_SET,
+            PARAM_ISO_MODE, "ISO1600", PARAM_ISO_MODE, "1600"),
+
+    /* Photos: Correct exposed ISO values */
+    FIXUP_ALWAYS(FIXUP_VARIANT_COMMON, BACK_CAMERA_ID, FIXUP_GET,
+            PARAM_SUPPORTED_ISO_MODES, "auto,ISO100,ISO200,ISO400,ISO800"),
+    FIXUP_ALWAYS(FIXUP_VARIANT_DERP2, BACK_CAMERA_ID, FIXUP_GET,
+            PARAM_SUPPORTED_ISO_MODES, "auto,ISO100,ISO200,ISO400,ISO800,ISO1600"),
+    FIXUP_ALWAYS(FIXUP_VARIANT_COMMON, FRONT_CAMERA_ID, FIXUP_GET,
+            PARAM_SUPPORTED_ISO_MODES, "auto"),
+
+    /* Fix exposure settings */
+    FIXUP_ALWAYS(FIXUP_VARIANT_DERP2, FIXUP_ANY_CAMERA, FIXUP_GET,
+            PARAM_EXPOSURE_COMPENSATION_STEP, "0.5"),
+    FIXUP_ALWAYS(FIXUP_VARIANT_DERP2, FIXUP_ANY_CAMERA, FIXUP_GET,
+            PARAM_MIN_EXPOSURE_COMPENSATION, "-4"),
+    FIXUP_ALWAYS(FIXUP_VARIANT_DERP2, FIXUP_ANY_CAMERA, FIXUP_GET,
+            PARAM_MAX_EXPOSURE_COMPENSATION, "4"),
+
+    /* Sure, it's supported, but not here */
+    FIXUP_ALWAYS(FIXUP_VARIANT_DERP2, FIXUP_ANY_CAMERA, FIXUP_GET,
+            PARAM_VIDEO_SNAPSHOT_SUPPORTED, "false"),
+
+    FIXUP_ALWAYS(FIXUP_VARIANT_PREVIEW_SIZE, BACK_CAMERA_ID, FIXUP_GET,
+            PARAM_PREFERRED_PREVIEW_SIZE_FOR_VIDEO, "800x480"),
+    FIXUP_ALWAYS(FIXUP_VARIANT_PREVIEW_SIZE, FRONT_CAMERA_ID, FIXUP_GET,
+            PARAM_PREFERRED_PREVIEW_SIZE_FOR_VIDEO, "640x480"),
+
+    /* Disable all forms of face detection */
+    FIXUP_ALWAYS(FIXUP_VARIANT_COMMON, FIXUP_ANY_CAMERA, FIXUP_GET,
+            PARAM_MAX_NUM_DETECTED_FACES_HW, "0"),
+    FIXUP_ALWAYS(FIXUP_VARIANT_COMMON, FIXUP_ANY_CAMERA, FIXUP_GET,
+            PARAM_MAX_NUM_DETECTED_FACES_SW, "0"),
+    FIXUP_ALWAYS(FIXUP_VARIANT_COMMON, FIXUP_ANY_CAMERA, FIXUP_GET,
+            PARAM_FACE_DETECTION, "off"),
+    FIXUP_ALWAYS(FIXUP_VARIANT_COMMON, FIXUP_ANY_CAMERA, FIXUP_GET,
+            PARAM_SUPPORTED_FACE_DETECTION, "off"),
+
+    /* ZSL: Always set KEY_SAMSUNG_CAMERA_MODE to 1 */
+    FIXUP_WHEN(FIXUP_VARIANT_DERP2, FIXUP_ANY_CAMERA, FIXUP_SET,
+            PARAM_ZSL, "on", PARAM_SAMSUNG_CAMERA_MODE, "1"),
+
+    /* Front camera: camera mode follows the recording hint */
+    FIXUP_ALWAYS(FIXUP_VARIANT_DERP2, FRONT_CAMERA_ID, FIXUP_SET,
+            PARAM_SAMSUNG_CAMERA_MODE, "0"),
+    FIXUP_WHEN(FIXUP_VARIANT_DERP2, FRONT_CAMERA_ID, FIXUP_SET,
+            PARAM_RECORDING_HINT, "true", PARAM_SAMSUNG_CAMERA_MODE, "1"),
+    FIXUP_ALWAYS(FIXUP_VARIANT_DERP2, FRONT_CAMERA_ID, FIXUP_SET,
+            PARAM_SUPPORTED_PREVIEW_SIZES, "960x720"),
+};
+
+#define ALL_FIXUP_RULES (sizeof(all_fixup_rules) / sizeof(all_fixup_rules[0]))
+
+/* The rules of this board's variants, resolved at compile time */
+struct fixup_rule_table {
+    fixup_rule_t rules[ALL_FIXUP_RULES];
+    size_t count;
+};
+
+static constexpr fixup_rule_table select_fixup_rules()
+{
+    fixup_rule_table table = {};
+
+    for (size_t i = 0; i < ALL_FIXUP_RULES; i++) {
+        if (all_fixup_rules[i].variants & kFixupVariants)
+            table.rules[table.count++] = all_fixup_rules[i];
+    }
+
+    return table;
+}
+
+static constexpr fixup_rule_table fixup_rules = select_fixup_rules();
+
+/*
+ * Perfect hash over param_keys: FNV-1a with a seed searched at compile
+ * time so that no two keys share a slot. Looking up the key of every pair
+ * in a parameter string then costs one hash and one compare.
+ */
+#define PARAM_HASH_SIZE 64
+
+static constexpr uint32_t param_hash(const char *s, size_t len, uint32_t seed)
+{
+    uint32_t h = 2166136261u ^ seed;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+
+    return h % PARAM_HASH_SIZE;
+}
+
+static constexpr size_t const_strlen(const char *s)
+{
+    size_t len = 0;
+
+    while (s[len])
+        len++;
+
+    return len;
+}
+
+static constexpr bool param_seed_is_perfect(uint32_t seed)
+{
+    bool used[PARAM_HASH_SIZE] = {};
+
+    for (int i = 0; i < PARAM_KEY_MAX; i++) {
+        uint32_t h = param_hash(param_keys[i], const_strlen(param_keys[i]), seed);
+        if (used[h])
+            return false;
+        used[h] = true;
+    }
+
+    return true;
+}
+
+static constexpr uint32_t find_param_seed()
+{
+    for (uint32_t seed = 0; seed < 4096; seed++) {
+        if (param_seed_is_perfect(seed))
+            return seed;
+    }
+
+    return UINT32_MAX;
+}
+
+static constexpr uint32_t kParamSeed = find_param_seed();
+static_assert(kParamSeed != UINT32_MAX,
+        "no perfect hash seed for param_keys, grow PARAM_HASH_SIZE");
+
+struct param_hash_table {
+    int8_t slots[PARAM_HASH_SIZE];
+};
+
+static constexpr param_hash_table build_param_hash()
+{
+    param_hash_table table = {};
+
+    for (int i = 0; i < PARAM_HASH_SIZE; i++)
+        table.slots[i] = -1;
+
+    for (int i = 0; i < PARAM_KEY_MAX; i++)
+        table.slots[param_hash(param_keys[i], const_strlen(param_keys[i]),
+                kParamSeed)] = i;
+
+    return table;
+}
+
+static constexpr param_hash_table param_slots = build_param_hash();
+
+/* The param_key named by the first len bytes of s, or -1 */
+static inline int find_param_key(const char *s, size_t len)
+{
+    int key = param_slots.slots[param_hash(s, len, kParamSeed)];
+
+    if (key < 0 || strncmp(param_keys[key], s, len) || param_keys[key][len])
+        return -1;
+
+    return key;
+}
+
+#endif // CAMERA_FIXUPS_H
@@ -22,33 +22,34 @@
 *
 */
 
-#define LOG_NDEBUG 0
-
 #define LOG_TAG "CameraWrapper"
 #include <cutils/log.h>
+#include <cutils/properties.h>
+
+#include <atomic>
+#include <inttypes.h>
+#include <new>
 
 #include <utils/threads.h>
 #include <utils/String8.h>
+#include <utils/Timers.h>
 #include <hardware/hardware.h>
 #include <hardware/camera.h>
 #include <camera/Camera.h>
 #include <camera/CameraParameters.h>
+#include <latency_histogram.h>
 
-#define BACK_CAMERA_ID 0
-#define FRONT_CAMERA_ID 1
+#include "CameraFixups.h"
 
 using namespace android;
 
+/*
+ * Only guards loading the vendor module and handing out preallocated
+ * wrappers, devices have their own lock.
+ */
 static Mutex gCameraWrapperLock;
 static camera_module_t *gVendorModule = 0;
 
-#ifdef DERP2
-static bool CAF = false;
-const static char *iso_values[] = {"auto,ISO100,ISO200,ISO400,ISO800,ISO1600","auto"};
-#else
-const static char *iso_values[] = {"auto,ISO100,ISO200,ISO400,ISO800","auto"};
-#endif
-
 static int camera_device_open(const hw_module_t *module, const char *name,
         hw_device_t **device);
 static int camera_get_number_of_cameras(void);
@@ -82,56 +83,764 @@ camera_module_t HAL_MODULE_INFO_SYM = {
     .reserved = {0}, /* remove compilation warnings */
 };
 
+#define MAX_CAMERAS 2
+
+/* Recording frames handed out and not released yet, oldest first */
+#define MAX_PENDING_FRAMES 32
+
+typedef struct frame_stats {
+    nsecs_t last;
+    /* Moving average of the interval between frames */
+    nsecs_t interval_avg;
+    nsecs_t interval_max;
+    uint32_t frames;
+    /* Frames missing from gaps longer than 1.5 average intervals */
+    uint32_t dropped;
+} frame_stats_t;
+
+typedef struct release_stats {
+    nsecs_t pending[MAX_PENDING_FRAMES];
+    uint32_t head;
+    uint32_t tail;
+    nsecs_t latency_avg;
+    nsecs_t latency_max;
+    uint32_t released;
+} release_stats_t;
+
 typedef struct wrapper_camera_device {
     camera_device_t base;
     int id;
     camera_device_t *vendor;
+
+    /* One of gCameraDevices, reused rather than freed on close */
+    bool preallocated;
+    /* Set while a preallocated wrapper is handed out, under gCameraWrapperLock */
+    bool in_use;
+
+    /* Guards the state below, which belongs to this camera only */
+    Mutex lock;
+    /* When the device was opened, until its first preview has started */
+    nsecs_t open_time;
+    /* Continuous focus mode, as set by the last set_parameters */
+    bool caf;
+    /* Last vendor parameters seen by camera_get_parameters and their fixup */
+    String8 vendor_parameters;
+    String8 fixed_parameters;
+    /* Last parameters the vendor HAL accepted from set_parameters */
+    String8 applied_parameters;
+    /* Counted in gRecordingCount, under gPowerHintLock */
+    bool recording;
+
+    /* Callbacks of the client when they are interposed, see set_callbacks */
+    camera_notify_callback notify_cb;
+    camera_data_callback data_cb;
+    camera_data_timestamp_callback data_cb_timestamp;
+    camera_request_memory get_memory;
+    void *user;
+
+    /* Frame delivery statistics, guarded by stats_lock */
+    Mutex stats_lock;
+    frame_stats_t preview_stats;
+    frame_stats_t video_stats;
+    release_stats_t release_stats;
 } wrapper_camera_device_t;
 
+/*
+ * Tracing is off unless persist.camera.wrapper.trace is set when the
+ * wrapper is loaded: 1 logs every call, 2 also logs parameter strings before and
+ * after the fixups. When off, each call site costs a single branch.
+ */
+#define TRACE_PROP "persist.camera.wrapper.trace"
+
+enum {
+    TRACE_OFF = 0,
+    TRACE_CALLS,
+    TRACE_PARAMS,
+};
+
+static int gTraceLevel = property_get_int32(TRACE_PROP, TRACE_OFF);
+
+#define TRACE(level, fmt, ...) do { \
+    if (__builtin_expect(gTraceLevel >= (level), 0)) \
+        ALOGD(fmt, ##__VA_ARGS__); \
+} while (0)
+
+#define TRACE_CALL(device) \
+    TRACE(TRACE_CALLS, "%s->%08X->%08X", __FUNCTION__, (uintptr_t)(device), \
+            (uintptr_t)(((wrapper_camera_device_t*)(device))->vendor))
+
+#define CAMERA_OPS(OP) \
+    OP(set_preview_window) \
+    OP(set_callbacks) \
+    OP(enable_msg_type) \
+    OP(disable_msg_type) \
+    OP(msg_type_enabled) \
+    OP(start_preview) \
+    OP(stop_preview) \
+    OP(preview_enabled) \
+    OP(store_meta_data_in_buffers) \
+    OP(start_recording) \
+    OP(stop_recording) \
+    OP(recording_enabled) \
+    OP(release_recording_frame) \
+    OP(auto_focus) \
+    OP(cancel_auto_focus) \
+    OP(take_picture) \
+    OP(cancel_picture) \
+    OP(set_parameters) \
+    OP(get_parameters) \
+    OP(put_parameters) \
+    OP(send_command) \
+    OP(release) \
+    OP(dump)
+
+#define CAMERA_OP_ENUM(op) CAMERA_OP_##op,
+#define CAMERA_OP_NAME(op) #op,
+
+enum camera_op {
+    CAMERA_OPS(CAMERA_OP_ENUM)
+    CAMERA_OP_MAX
+};
+
+static const char *camera_op_names[CAMERA_OP_MAX] = {
+    CAMERA_OPS(CAMERA_OP_NAME)
+};
+
+/*
+ * With persist.camera.wrapper.trace_ring set when the wrapper is loaded,
+ * the last TRACE_RING_SIZE vendor calls are kept as fixed-size records and
+ * printed by camera_dump() for offline analysis, without anything going
+ * through logcat.
+ */
+#define TRACE_RING_PROP "persist.camera.wrapper.trace_ring"
+#define TRACE_RING_SIZE 1024
+
+typedef struct trace_record {
+    nsecs_t start;
+    nsecs_t duration;
+    uint8_t op;
+    int8_t camera_id;
+} trace_record_t;
+
+static bool gTraceRing = property_get_bool(TRACE_RING_PROP, false);
+static trace_record_t gTraceRecords[TRACE_RING_SIZE];
+static std::atomic<uint32_t> gTraceNext(0);
+
+/*
+ * Every vendor call is timed into a log2 histogram per camera and op, the
+ * same as the power HAL's hints (see latency_histogram.h). camera_dump()
+ * reports them, so slow focus or shutter can be told apart from wrapper
+ * overhead. Call counts are the sums of the buckets.
+ */
+typedef struct op_stats {
+    std::atomic<uint64_t> total;
+    std::atomic<uint32_t> buckets[LATENCY_BUCKETS];
+} op_stats_t;
+
+static op_stats_t gOpStats[MAX_CAMERAS][CAMERA_OP_MAX];
+
+/* set_parameters calls that were not forwarded as nothing changed */
+static std::atomic<uint32_t> gSetParametersSuppressed[MAX_CAMERAS];
+
+/* Times the vendor call made during its lifetime */
+class VendorCallTrace {
+public:
+    VendorCallTrace(int op, int id) :
+        mStart(systemTime(SYSTEM_TIME_MONOTONIC)), mOp(op), mId(id) {}
+
+    ~VendorCallTrace() {
+        nsecs_t duration = systemTime(SYSTEM_TIME_MONOTONIC) - mStart;
+
+        if (mId >= 0 && mId < MAX_CAMERAS) {
+            op_stats_t *stats = &gOpStats[mId][mOp];
+
+            stats->total.fetch_add(duration, std::memory_order_relaxed);
+            stats->buckets[latency_bucket(duration)].fetch_add(1,
+                    std::memory_order_relaxed);
+        }
+
+        if (__builtin_expect(!gTraceRing, 1))
+            return;
+
+        uint32_t slot = gTraceNext.fetch_add(1, std::memory_order_relaxed);
+        trace_record_t *record = &gTraceRecords[slot % TRACE_RING_SIZE];
+
+        record->start = mStart;
+        record->duration = duration;
+        record->op = mOp;
+        record->camera_id = mId;
+    }
+
+private:
+    nsecs_t mStart;
+    int mOp;
+    int mId;
+};
+
+static void dump_op_stats(int fd, int id)
+{
+    unsigned long buckets[LATENCY_BUCKETS];
+    unsigned long count;
+    uint64_t total;
+    int op, b;
+
+    if (id < 0 || id >= MAX_CAMERAS)
+        return;
+
+    for (op = 0; op < CAMERA_OP_MAX; op++) {
+        op_stats_t *stats = &gOpStats[id][op];
+
+        count = 0;
+        for (b = 0; b < LATENCY_BUCKETS; b++) {
+            buckets[b] = stats->buckets[b].load(std::memory_order_relaxed);
+            count += buckets[b];
+        }
+        if (!count)
+            continue;
+
+        total = stats->total.load(std::memory_order_relaxed);
+        dprintf(fd, "camera.%d.%s.count=%lu\n", id, camera_op_names[op], count);
+        dprintf(fd, "camera.%d.%s.total_ns=%" PRIu64 "\n", id,
+                camera_op_names[op], total);
+        dprintf(fd, "camera.%d.%s.mean_ns=%" PRIu64 "\n", id,
+                camera_op_names[op], total / count);
+        dprintf(fd, "camera.%d.%s.p50_ns=%llu\n", id, camera_op_names[op],
+                latency_percentile_ns(buckets, count, 500));
+        dprintf(fd, "camera.%d.%s.p99_ns=%llu\n", id, camera_op_names[op],
+                latency_percentile_ns(buckets, count, 990));
+        dprintf(fd, "camera.%d.%s.p999_ns=%llu\n", id, camera_op_names[op],
+                latency_percentile_ns(buckets, count, 999));
+
+        /* Estimated from what the calls that did go through took */
+        if (op == CAMERA_OP_set_parameters) {
+            uint32_t suppressed = gSetParametersSuppressed[id].load();
+
+            dprintf(fd, "camera.%d.%s.suppressed=%u\n", id,
+                    camera_op_names[op], suppressed);
+            dprintf(fd, "camera.%d.%s.saved_ns=%" PRIu64 "\n", id,
+                    camera_op_names[op], suppressed * (total / count));
+        }
+    }
+}
+
 #define VENDOR_CALL(device, func, ...) ({ \
     wrapper_camera_device_t *__wrapper_dev = (wrapper_camera_device_t*) device; \
+    VendorCallTrace __trace(CAMERA_OP_##func, __wrapper_dev->id); \
     __wrapper_dev->vendor->ops->func(__wrapper_dev->vendor, ##__VA_ARGS__); \
 })
 
 #define CAMERA_ID(device) (((wrapper_camera_device_t *)(device))->id)
 
+static std::atomic<uint32_t> gParametersCacheHits(0);
+static std::atomic<uint32_t> gParametersCacheMisses(0);
+
+/* Cold start costs, reported by camera_dump() */
+static nsecs_t gVendorModuleLoadTime = 0;
+static std::atomic<int64_t> gOpenToPreviewTime[MAX_CAMERAS];
+
+/*
+ * The number of cameras and their info don't change for a given boot, but
+ * CameraService and apps keep asking while enumerating. Only the first
+ * successful answer from the vendor module is asked for, the rest are
+ * served from here. No cameras or an error is not cached, so a module that
+ * wasn't ready yet is asked again next time.
+ */
+static Mutex gCameraInfoLock;
+static int gNumberOfCameras = -1;
+static bool gCameraInfoValid[MAX_CAMERAS];
+static struct camera_info gCameraInfo[MAX_CAMERAS];
+static std::atomic<uint32_t> gVendorQueriesSaved(0);
+
 static char *camera_get_parameters(struct camera_device *device);
 static int camera_set_parameters(struct camera_device *device,
         const char *params);
 
+/*******************************************************************
+ * power hints
+ *******************************************************************/
+
+/*
+ * Performance requests go to the power HAL in system_server through the
+ * properties it watches. A capture or focus asks for a boost of a bounded
+ * number of milliseconds, which the power HAL merges and lets expire on
+ * its own. Recording holds the encode profile while CAMERA_RECORDING_PROP
+ * is 1; it is counted across cameras so that the property only changes on
+ * the first start and the last stop. On by default, disabled by setting
+ * persist.camera.wrapper.power_hints to false before the wrapper is loaded.
+ */
+#define POWER_HINTS_PROP "persist.camera.wrapper.power_hints"
+#define CAMERA_BOOST_PROP "sys.power.camera.boost"
+#define CAMERA_RECORDING_PROP "sys.power.camera.recording"
+
+/* The tests build the wrapper with properties of their own */
+#ifndef CAMERA_POWER_PROPERTY_GET
+#define CAMERA_POWER_PROPERTY_GET property_get
+#endif
+#ifndef CAMERA_POWER_PROPERTY_SET
+#define CAMERA_POWER_PROPERTY_SET property_set
+#endif
+
+#define CAPTURE_BOOST_MS 1500
+#define FOCUS_BOOST_MS 1000
+
+static bool gPowerHints = property_get_bool(POWER_HINTS_PROP, true);
+static Mutex gPowerHintLock;
+static int gRecordingCount = 0;
+
+/*
+ * Setting a property is a round trip to init, which a capture or focus
+ * shouldn't wait for, so boosts are set from a thread of their own. It is
+ * started on the first boost; requests made while it is busy are merged
+ * into the longest one.
+ */
+static pthread_once_t gPowerBoostOnce = PTHREAD_ONCE_INIT;
+static bool gPowerBoostThread = false;
+static Mutex gPowerBoostLock;
+static Condition gPowerBoostCond;
+static int gPowerBoostPendingMs = 0;
+
+static void camera_power_boost_set(int ms)
+{
+    char value[PROPERTY_VALUE_MAX];
+
+    snprintf(value, sizeof(value), "%d", ms);
+    CAMERA_POWER_PROPERTY_SET(CAMERA_BOOST_PROP, value);
+}
+
+static void *camera_power_boost_thread(void *)
+{
+    int ms;
+
+    for (;;) {
+        {
+            Mutex::Autolock lock(gPowerBoostLock);
+            while (!gPowerBoostPendingMs)
+                gPowerBoostCond.wait(gPowerBoostLock);
+            ms = gPowerBoostPendingMs;
+            gPowerBoostPendingMs = 0;
+        }
+        camera_power_boost_set(ms);
+    }
+
+    return NULL;
+}
+
+static void camera_power_boost_start(void)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, camera_power_boost_thread, NULL))
+        ALOGE("failed to start the power boost thread");
+    else
+        gPowerBoostThread = true;
+    pthread_attr_destroy(&attr);
+}
+
+static void camera_power_boost(int ms)
+{
+    if (!gPowerHints)
+        return;
+
+    pthread_once(&gPowerBoostOnce, camera_power_boost_start);
+    if (!gPowerBoostThread) {
+        camera_power_boost_set(ms);
+        return;
+    }
+
+    Mutex::Autolock lock(gPowerBoostLock);
+    if (ms > gPowerBoostPendingMs)
+        gPowerBoostPendingMs = ms;
+    gPowerBoostCond.signal();
+}
+
+static void camera_power_recording(wrapper_camera_device_t *wrapper,
+        bool recording)
+{
+    Mutex::Autolock lock(gPowerHintLock);
+
+    /* Only requests that were made are released */
+    if (wrapper->recording == recording || (recording && !gPowerHints))
+        return;
+
+    wrapper->recording = recording;
+    if (recording ? gRecordingCount++ == 0 : --gRecordingCount == 0)
+        CAMERA_POWER_PROPERTY_SET(CAMERA_RECORDING_PROP, recording ? "1" : "0");
+}
+
+/*
+ * A previous mediaserver may have died while recording, leave nothing
+ * held for it. Called once, when the vendor module is loaded.
+ */
+static void camera_power_reset(void)
+{
+    char value[PROPERTY_VALUE_MAX];
+
+    CAMERA_POWER_PROPERTY_GET(CAMERA_RECORDING_PROP, value, "0");
+    if (strcmp(value, "0"))
+        CAMERA_POWER_PROPERTY_SET(CAMERA_RECORDING_PROP, "0");
+}
+
 static int check_vendor_module()
 {
     int rv = 0;
-    ALOGV("%s", __FUNCTION__);
+    TRACE(TRACE_CALLS, "%s", __FUNCTION__);
+
+    Mutex::Autolock lock(gCameraWrapperLock);
 
     if (gVendorModule)
         return 0;
 
+    nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
     rv = hw_get_module_by_class("camera", "vendor",
             (const hw_module_t**)&gVendorModule);
+    gVendorModuleLoadTime = systemTime(SYSTEM_TIME_MONOTONIC) - start;
 
     if (rv)
         ALOGE("failed to open vendor camera module %d", rv);
 
+    if (!rv)
+        camera_power_reset();
+
     return rv;
 }
 
+/*
+ * With ro.camera.wrapper.preload set, the vendor module is loaded and
+ * resolved as soon as this library is, instead of on the first call that
+ * needs it. This is defined after gCameraWrapperLock, so it is constructed
+ * after it.
+ */
+#define PRELOAD_PROP "ro.camera.wrapper.preload"
+
+static struct VendorModulePreload {
+    VendorModulePreload() {
+        if (property_get_bool(PRELOAD_PROP, false))
+            check_vendor_module();
+    }
+} gVendorModulePreload;
+
+/*******************************************************************
+ * parameter string rewriting
+ *******************************************************************/
+
+/*
+ * Values of the keys in param_keys, as found in a flattened parameter
+ * string. They point into the string and are not terminated.
+ */
+typedef struct param_values {
+    const char *value[PARAM_KEY_MAX];
+    size_t len[PARAM_KEY_MAX];
+} param_values_t;
+
+/* End of the key=value pair starting at params */
+static const char *next_parameter(const char *params)
+{
+    const char *end = strchr(params, ';');
+
+    return end ? end : params + strlen(params);
+}
+
+static void scan_parameters(const char *params, param_values_t *found)
+{
+    const char *end, *eq;
+    int key;
+
+    memset(found, 0, sizeof(*found));
+
+    while (*params) {
+        end = next_parameter(params);
+        eq = (const char *)memchr(params, '=', end - params);
+        if (eq) {
+            key = find_param_key(params, eq - params);
+            if (key >= 0) {
+                found->value[key] = eq + 1;
+                found->len[key] = end - eq - 1;
+            }
+        }
+        params = *end ? end + 1 : end;
+    }
+}
+
+static bool parameter_equals(const param_values_t *found, int key,
+        const char *value)
+{
+    return found->value[key] && found->len[key] == strlen(value) &&
+            !strncmp(found->value[key], value, found->len[key]);
+}
+
+/* Work out the new value of every key this board's rules change */
+static void apply_fixup_rules(int id, enum fixup_direction direction,
+        const param_values_t *found, const char **fixed)
+{
+    const fixup_rule_t *rule;
+    size_t i;
+
+    for (i = 0; i < fixup_rules.count; i++) {
+        rule = &fixup_rules.rules[i];
+
+        if (rule->direction != direction)
+            continue;
+        if (rule->camera_id != FIXUP_ANY_CAMERA && rule->camera_id != id)
+            continue;
+        if (rule->match && !parameter_equals(found, rule->key, rule->match))
+            continue;
+
+        fixed[rule->target] = rule->value;
+    }
+}
+
+/*
+ * Copy a flattened parameter string in a single pass, substituting the
+ * value of every key that has one in fixed and appending the ones it did
+ * not contain. Unlike unflatten(), set() and flatten() on CameraParameters,
+ * which sort the keys and drop duplicates, the original key order and any
+ * duplicate keys that are not fixed are kept, so the result is only
+ * equivalent once unflattened (see MatchesCameraParametersPath in the
+ * tests). That saves a String8 for every key and value: the output buffer
+ * is sized up front and is the only allocation. It is malloc'd so that it
+ * can be handed out by camera_get_parameters() as is.
+ */
+static char *rewrite_parameters(const char *params, const char *const *fixed)
+{
+    bool applied[PARAM_KEY_MAX] = { false };
+    const char *end, *eq;
+    size_t len;
+    char *out, *p;
+    int key;
+
+    len = strlen(params) + 1;
+    for (key = 0; key < PARAM_KEY_MAX; key++) {
+        if (fixed[key])
+            len += strlen(param_keys[key]) + strlen(fixed[key]) + 2;
+    }
+
+    out = (char *)malloc(len);
+    if (!out)
+        return NULL;
+
+    p = out;
+    while (*params) {
+        end = next_parameter(params);
+        eq = (const char *)memchr(params, '=', end - params);
+        key = eq ? find_param_key(params, eq - params) : -1;
+
+        if (key >= 0 && fixed[key]) {
+            /* Substituted keys are only written once */
+            if (!applied[key]) {
+                if (p != out)
+                    *p++ = ';';
+                p = stpcpy(p, param_keys[key]);
+                *p++ = '=';
+                p = stpcpy(p, fixed[key]);
+                applied[key] = true;
+            }
+        } else if (end != params) {
+            if (p != out)
+                *p++ = ';';
+            memcpy(p, params, end - params);
+            p += end - params;
+        }
+
+        params = *end ? end + 1 : end;
+    }
+
+    for (key = 0; key < PARAM_KEY_MAX; key++) {
+        if (!fixed[key] || applied[key])
+            continue;
+        if (p != out)
+            *p++ = ';';
+        p = stpcpy(p, param_keys[key]);
+        *p++ = '=';
+        p = stpcpy(p, fixed[key]);
+    }
+    *p = '\0';
+
+    return out;
+}
+
+/* Apply the board's fixup rules for one camera and direction */
+static char *fixup_parameters(int id, enum fixup_direction direction,
+        const char *params, param_values_t *found)
+{
+    const char *fixed[PARAM_KEY_MAX] = { NULL };
+
+    scan_parameters(params, found);
+    apply_fixup_rules(id, direction, found, fixed);
+
+    return rewrite_parameters(params, fixed);
+}
+
 /*******************************************************************
  * implementation of camera_device_ops functions
  *******************************************************************/
 
+/*
+ * Preview, capture, focus and recording transitions, and commands like
+ * smooth zoom, change parameters behind our back. The next set_parameters
+ * has to reach the vendor HAL even if it matches the last one.
+ */
+static void forget_applied_parameters(struct camera_device *device)
+{
+    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)device;
+
+    Mutex::Autolock lock(wrapper->lock);
+    wrapper->applied_parameters.clear();
+}
+
 static int camera_set_preview_window(struct camera_device *device,
         struct preview_stream_ops *window)
 {
     if (!device)
         return -EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     return VENDOR_CALL(device, set_preview_window, window);
 }
 
+/*
+ * With persist.camera.wrapper.frame_stats set when the wrapper is loaded,
+ * the client's callbacks are interposed so that preview and recording frame
+ * delivery can be measured. Frames are passed through as they are, the
+ * camera_memory_t is never copied.
+ */
+#define FRAME_STATS_PROP "persist.camera.wrapper.frame_stats"
+
+static bool gFrameStats = property_get_bool(FRAME_STATS_PROP, false);
+
+static void record_frame(frame_stats_t *stats, nsecs_t now)
+{
+    nsecs_t interval;
+
+    stats->frames++;
+    if (!stats->last) {
+        stats->last = now;
+        return;
+    }
+
+    interval = now - stats->last;
+    stats->last = now;
+
+    if (interval > stats->interval_max)
+        stats->interval_max = interval;
+
+    /* Let the average settle before counting gaps as drops */
+    if (stats->frames > 8 && stats->interval_avg &&
+            interval * 2 > stats->interval_avg * 3)
+        stats->dropped += (interval + stats->interval_avg / 2) /
+                stats->interval_avg - 1;
+
+    if (!stats->interval_avg)
+        stats->interval_avg = interval;
+    else
+        stats->interval_avg += (interval - stats->interval_avg) / 16;
+}
+
+static void wrapper_notify_cb(int32_t msg_type, int32_t ext1, int32_t ext2,
+        void *user)
+{
+    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)user;
+
+    wrapper->notify_cb(msg_type, ext1, ext2, wrapper->user);
+}
+
+static void wrapper_data_cb(int32_t msg_type, const camera_memory_t *data,
+        unsigned int index, camera_frame_metadata_t *metadata, void *user)
+{
+    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)user;
+
+    if (msg_type & CAMERA_MSG_PREVIEW_FRAME) {
+        Mutex::Autolock lock(wrapper->stats_lock);
+        record_frame(&wrapper->preview_stats, systemTime(SYSTEM_TIME_MONOTONIC));
+    }
+
+    wrapper->data_cb(msg_type, data, index, metadata, wrapper->user);
+}
+
+static void wrapper_data_cb_timestamp(nsecs_t timestamp, int32_t msg_type,
+        const camera_memory_t *data, unsigned int index, void *user)
+{
+    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)user;
+
+    if (msg_type & CAMERA_MSG_VIDEO_FRAME) {
+        Mutex::Autolock lock(wrapper->stats_lock);
+        release_stats_t *release = &wrapper->release_stats;
+
+        record_frame(&wrapper->video_stats, timestamp);
+        if (release->tail - release->head < MAX_PENDING_FRAMES)
+            release->pending[release->tail++ % MAX_PENDING_FRAMES] =
+                    systemTime(SYSTEM_TIME_MONOTONIC);
+    }
+
+    wrapper->data_cb_timestamp(timestamp, msg_type, data, index, wrapper->user);
+}
+
+static camera_memory_t *wrapper_get_memory(int fd, size_t buf_size,
+        unsigned int num_bufs, void *user)
+{
+    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)user;
+
+    return wrapper->get_memory(fd, buf_size, num_bufs, wrapper->user);
+}
+
+/*
+ * The recorder hands frames back in the order it got them, so the oldest
+ * pending delivery is the one being released.
+ */
+static void record_frame_release(wrapper_camera_device_t *wrapper)
+{
+    Mutex::Autolock lock(wrapper->stats_lock);
+    release_stats_t *release = &wrapper->release_stats;
+    nsecs_t latency;
+
+    if (release->head == release->tail)
+        return;
+
+    latency = systemTime(SYSTEM_TIME_MONOTONIC) -
+            release->pending[release->head++ % MAX_PENDING_FRAMES];
+
+    release->released++;
+    if (latency > release->latency_max)
+        release->latency_max = latency;
+    if (!release->latency_avg)
+        release->latency_avg = latency;
+    else
+        release->latency_avg += (latency - release->latency_avg) / 16;
+}
+
+static void dump_frame_stats(int fd, wrapper_camera_device_t *wrapper)
+{
+    Mutex::Autolock lock(wrapper->stats_lock);
+    const frame_stats_t *stats[] = {
+        &wrapper->preview_stats,
+        &wrapper->video_stats,
+    };
+    const char *names[] = { "preview", "video" };
+    const release_stats_t *release = &wrapper->release_stats;
+    size_t i;
+
+    for (i = 0; i < sizeof(stats) / sizeof(stats[0]); i++) {
+        dprintf(fd, "camera.%d.%s.frames=%u\n", wrapper->id, names[i],
+                stats[i]->frames);
+        dprintf(fd, "camera.%d.%s.dropped=%u\n", wrapper->id, names[i],
+                stats[i]->dropped);
+        dprintf(fd, "camera.%d.%s.interval_avg_ns=%" PRId64 "\n", wrapper->id,
+                names[i], stats[i]->interval_avg);
+        dprintf(fd, "camera.%d.%s.interval_max_ns=%" PRId64 "\n", wrapper->id,
+                names[i], stats[i]->interval_max);
+    }
+
+    dprintf(fd, "camera.%d.video.released=%u\n", wrapper->id,
+            release->released);
+    dprintf(fd, "camera.%d.video.release_avg_ns=%" PRId64 "\n", wrapper->id,
+            release->latency_avg);
+    dprintf(fd, "camera.%d.video.release_max_ns=%" PRId64 "\n", wrapper->id,
+            release->latency_max);
+}
+
 static void camera_set_callbacks(struct camera_device *device,
         camera_notify_callback notify_cb,
         camera_data_callback data_cb,
@@ -139,14 +848,32 @@ static void camera_set_callbacks(struct camera_device *device,
         camera_request_memory get_memory,
         void *user)
 {
+    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)device;
+
     if (!device)
         return;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
-    VENDOR_CALL(device, set_callbacks, notify_cb, data_cb, data_cb_timestamp,
-            get_memory, user);
+    if (!gFrameStats) {
+        VENDOR_CALL(device, set_callbacks, notify_cb, data_cb,
+                data_cb_timestamp, get_memory, user);
+        return;
+    }
+
+    /* The vendor HAL passes its user pointer to every callback */
+    wrapper->notify_cb = notify_cb;
+    wrapper->data_cb = data_cb;
+    wrapper->data_cb_timestamp = data_cb_timestamp;
+    wrapper->get_memory = get_memory;
+    wrapper->user = user;
+
+    VENDOR_CALL(device, set_callbacks,
+            notify_cb ? wrapper_notify_cb : NULL,
+            data_cb ? wrapper_data_cb : NULL,
+            data_cb_timestamp ? wrapper_data_cb_timestamp : NULL,
+            get_memory ? wrapper_get_memory : NULL,
+            wrapper);
 }
 
 static void camera_enable_msg_type(struct camera_device *device,
@@ -155,8 +882,7 @@ static void camera_enable_msg_type(struct camera_device *device,
     if (!device)
         return;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     VENDOR_CALL(device, enable_msg_type, msg_type);
 }
@@ -167,8 +893,7 @@ static void camera_disable_msg_type(struct camera_device *device,
     if (!device)
         return;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     VENDOR_CALL(device, disable_msg_type, msg_type);
 }
@@ -179,21 +904,36 @@ static int camera_msg_type_enabled(struct camera_device *device,
     if (!device)
         return 0;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     return VENDOR_CALL(device, msg_type_enabled, msg_type);
 }
 
 static int camera_start_preview(struct camera_device *device)
 {
+    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)device;
+    int ret;
+
     if (!device)
         return -EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
+
+    ret = VENDOR_CALL(device, start_preview);
+
+    Mutex::Autolock lock(wrapper->lock);
+    wrapper->applied_parameters.clear();
+    if (!ret && wrapper->open_time) {
+        nsecs_t elapsed = systemTime(SYSTEM_TIME_MONOTONIC) - wrapper->open_time;
 
-    return VENDOR_CALL(device, start_preview);
+        if (wrapper->id < MAX_CAMERAS)
+            gOpenToPreviewTime[wrapper->id] = elapsed;
+        TRACE(TRACE_CALLS, "%s: camera %d previewing %" PRId64 " ms after open",
+                __FUNCTION__, wrapper->id, elapsed / 1000000);
+        wrapper->open_time = 0;
+    }
+
+    return ret;
 }
 
 static void camera_stop_preview(struct camera_device *device)
@@ -201,10 +941,11 @@ static void camera_stop_preview(struct camera_device *device)
     if (!device)
         return;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     VENDOR_CALL(device, stop_preview);
+
+    forget_applied_parameters(device);
 }
 
 static int camera_preview_enabled(struct camera_device *device)
@@ -212,8 +953,7 @@ static int camera_preview_enabled(struct camera_device *device)
     if (!device)
         return -EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     return VENDOR_CALL(device, preview_enabled);
 }
@@ -224,21 +964,31 @@ static int camera_store_meta_data_in_buffers(struct camera_device *device,
     if (!device)
         return -EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     return VENDOR_CALL(device, store_meta_data_in_buffers, enable);
 }
 
 static int camera_start_recording(struct camera_device *device)
 {
+    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)device;
+    int ret;
+
     if (!device)
         return EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
+
+    /* Have the encode profile in place before the first frame */
+    camera_power_recording(wrapper, true);
+
+    ret = VENDOR_CALL(device, start_recording);
+    if (ret)
+        camera_power_recording(wrapper, false);
 
-    return VENDOR_CALL(device, start_recording);
+    forget_applied_parameters(device);
+
+    return ret;
 }
 
 static void camera_stop_recording(struct camera_device *device)
@@ -246,10 +996,11 @@ static void camera_stop_recording(struct camera_device *device)
     if (!device)
         return;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     VENDOR_CALL(device, stop_recording);
+
+    camera_power_recording((wrapper_camera_device_t *)device, false);
 }
 
 static int camera_recording_enabled(struct camera_device *device)
@@ -257,8 +1008,7 @@ static int camera_recording_enabled(struct camera_device *device)
     if (!device)
         return -EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     return VENDOR_CALL(device, recording_enabled);
 }
@@ -269,56 +1019,75 @@ static void camera_release_recording_frame(struct camera_device *device,
     if (!device)
         return;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
+
+    if (gFrameStats)
+        record_frame_release((wrapper_camera_device_t *)device);
 
     VENDOR_CALL(device, release_recording_frame, opaque);
 }
 
 static int camera_auto_focus(struct camera_device *device)
 {
+    int ret;
+
     if (!device)
         return -EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
+
+    camera_power_boost(FOCUS_BOOST_MS);
+
+    ret = VENDOR_CALL(device, auto_focus);
+    forget_applied_parameters(device);
 
-    return VENDOR_CALL(device, auto_focus);
+    return ret;
 }
 
 static int camera_cancel_auto_focus(struct camera_device *device)
 {
+    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)device;
+    bool caf;
     int ret = 0;
 
     if (!device)
         return -EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     /* APEXQ/EXPRESS: Calling cancel_auto_focus causes the camera to crash for unknown reasons.
      * Disabling it has no adverse effect. For others, only call cancel_auto_focus when the
      * preview is enabled. This is needed so some 3rd party camera apps don't lock up. */
-#ifdef DERP2
-    if (camera_preview_enabled(device)) {
-        if (CAF) {
-            camera_send_command(device, 1551, 0, 0);
+    if (kTrackContinuousFocus) {
+        if (camera_preview_enabled(device)) {
+            {
+                Mutex::Autolock lock(wrapper->lock);
+                caf = wrapper->caf;
+            }
+            if (caf) {
+                camera_send_command(device, 1551, 0, 0);
+            }
         }
     }
-#endif
 
     return ret;
 }
 
 static int camera_take_picture(struct camera_device *device)
 {
+    int ret;
+
     if (!device)
         return -EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
+
+    camera_power_boost(CAPTURE_BOOST_MS);
+
+    ret = VENDOR_CALL(device, take_picture);
+    forget_applied_parameters(device);
 
-    return VENDOR_CALL(device, take_picture);
+    return ret;
 }
 
 static int camera_cancel_picture(struct camera_device *device)
@@ -326,8 +1095,7 @@ static int camera_cancel_picture(struct camera_device *device)
     if (!device)
         return -EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     return VENDOR_CALL(device, cancel_picture);
 }
@@ -338,117 +1106,118 @@ static int camera_set_parameters(struct camera_device *device,
     if (!device)
         return -EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
-
-    int id = CAMERA_ID(device);
-
-    CameraParameters params;
-    params.unflatten(String8(settings));
+    TRACE_CALL(device);
 
-    ALOGV("%s: Original parameters:", __FUNCTION__);
-    params.dump();
-
-    /* Map the corrected ISO values to the ones in the HAL */
-    if(params.get("iso")) {
-        const char *isoMode = params.get(CameraParameters::KEY_ISO_MODE);
-        if(!strcmp(isoMode, "ISO100"))
-            params.set(CameraParameters::KEY_ISO_MODE, "100");
-        else if(!strcmp(isoMode, "ISO200"))
-            params.set(CameraParameters::KEY_ISO_MODE, "200");
-        else if(!strcmp(isoMode, "ISO400"))
-            params.set(CameraParameters::KEY_ISO_MODE, "400");
-        else if(!strcmp(isoMode, "ISO800"))
-            params.set(CameraParameters::KEY_ISO_MODE, "800");
-        else if(!strcmp(isoMode, "ISO1600"))
-            params.set(CameraParameters::KEY_ISO_MODE, "1600");
-    }
+    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)device;
+    int id = wrapper->id;
 
-#ifdef DERP2
-    bool isVideo = false;
-    bool isZsl = false;
-    int camMode = -1;
+    param_values_t found;
+    int ret;
 
-    if (params.get(CameraParameters::KEY_RECORDING_HINT))
-        isVideo = !strcmp(params.get(CameraParameters::KEY_RECORDING_HINT), "true");
+    TRACE(TRACE_PARAMS, "%s: Original parameters: %s", __FUNCTION__, settings);
 
-    if (params.get(CameraParameters::KEY_ZSL))
-        isZsl = !strcmp(params.get(CameraParameters::KEY_ZSL), "on");
+    char *fixed = fixup_parameters(id, FIXUP_SET, settings, &found);
+    if (!fixed)
+        return -ENOMEM;
 
-    /* ZSL: Always set KEY_SAMSUNG_CAMERA_MODE to 1 */
-    if (isZsl)
-        params.set(CameraParameters::KEY_SAMSUNG_CAMERA_MODE, "1");
+    if (kTrackContinuousFocus) {
+        Mutex::Autolock lock(wrapper->lock);
 
-    /* Reset continuous focus tracker */
-    CAF = false;
+        /* Reset continuous focus tracker */
+        wrapper->caf = false;
 
-    if (id == FRONT_CAMERA_ID) {
-        params.set(CameraParameters::KEY_SAMSUNG_CAMERA_MODE, isVideo ? "1" : "0");
-        params.set(CameraParameters::KEY_SUPPORTED_PREVIEW_SIZES, "960x720");
-    } else {
         /* Are we in continuous focus mode? */
-        if (strcmp(params.get(CameraParameters::KEY_FOCUS_MODE), "infinity") &&
-                strcmp(params.get(CameraParameters::KEY_FOCUS_MODE), "fixed")) {
-           CAF = true;
+        if (id != FRONT_CAMERA_ID && found.value[PARAM_FOCUS_MODE] &&
+                !parameter_equals(&found, PARAM_FOCUS_MODE, "infinity") &&
+                !parameter_equals(&found, PARAM_FOCUS_MODE, "fixed")) {
+           wrapper->caf = true;
         }
     }
-#endif
 
-    ALOGV("%s: Fixed parameters:", __FUNCTION__);
-    params.dump();
+    TRACE(TRACE_PARAMS, "%s: Fixed parameters: %s", __FUNCTION__, fixed);
+
+    /*
+     * Apps often set the same parameters over and over, and on this HAL
+     * every set can stall preview and rerun 3A, so skip it when nothing
+     * changed since the last one that went through.
+     */
+    {
+        Mutex::Autolock lock(wrapper->lock);
+
+        if (wrapper->applied_parameters == fixed) {
+            free(fixed);
+            if (id < MAX_CAMERAS)
+                gSetParametersSuppressed[id]++;
+            return 0;
+        }
+    }
 
-    String8 strParams = params.flatten();
+    ret = VENDOR_CALL(device, set_parameters, fixed);
 
-    return VENDOR_CALL(device, set_parameters, strParams);
-}
+    {
+        Mutex::Autolock lock(wrapper->lock);
 
-static char *camera_get_parameters(struct camera_device *device)
-{
-    if (!device)
-        return NULL;
+        if (ret)
+            wrapper->applied_parameters.clear();
+        else
+            wrapper->applied_parameters.setTo(fixed);
+    }
+    free(fixed);
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    return ret;
+}
 
-    int id = CAMERA_ID(device);
+/*
+ * Apply our fixups to the parameters reported by the vendor HAL. The result
+ * only depends on the camera id and the vendor string, which is what allows
+ * camera_get_parameters() to cache it.
+ */
+static char *fixup_get_parameters(int id, const char *parameters)
+{
+    param_values_t found;
+    char *ret;
 
-    char *parameters = VENDOR_CALL(device, get_parameters);
+    TRACE(TRACE_PARAMS, "%s: Original parameters: %s", __FUNCTION__, parameters);
 
-    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)device;
+    ret = fixup_parameters(id, FIXUP_GET, parameters, &found);
 
-    CameraParameters params;
-    params.unflatten(String8(parameters));
+    TRACE(TRACE_PARAMS, "%s: Fixed parameters: %s", __FUNCTION__, ret);
 
-    ALOGV("%s: Original parameters:", __FUNCTION__);
-    params.dump();
+    return ret;
+}
 
-    /* Photos: Correct exposed ISO values */
-    params.set(CameraParameters::KEY_SUPPORTED_ISO_MODES, iso_values[id]);
+static char *camera_get_parameters(struct camera_device *device)
+{
+    if (!device)
+        return NULL;
 
-#ifdef DERP2
-    /* Fix exposure settings */
-    params.set(CameraParameters::KEY_EXPOSURE_COMPENSATION_STEP, "0.5");
-    params.set(CameraParameters::KEY_MIN_EXPOSURE_COMPENSATION, "-4");
-    params.set(CameraParameters::KEY_MAX_EXPOSURE_COMPENSATION, "4");
+    TRACE_CALL(device);
 
-    /* Sure, it's supported, but not here */
-    params.set(CameraParameters::KEY_VIDEO_SNAPSHOT_SUPPORTED, "false");
-#endif
+    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)device;
 
-#ifdef PREVIEW_SIZE_FIXUP
-    params.set(CameraParameters::KEY_PREFERRED_PREVIEW_SIZE_FOR_VIDEO, id ? "640x480" : "800x480");
-#endif
+    char *parameters = VENDOR_CALL(device, get_parameters);
+    char *ret = NULL;
 
-    /* Disable all forms of face detection */
-    params.set(CameraParameters::KEY_MAX_NUM_DETECTED_FACES_HW, "0");
-    params.set(CameraParameters::KEY_MAX_NUM_DETECTED_FACES_SW, "0");
-    params.set(CameraParameters::KEY_FACE_DETECTION, "off");
-    params.set(CameraParameters::KEY_SUPPORTED_FACE_DETECTION, "off");
+    if (!parameters)
+        return NULL;
 
-    ALOGV("%s: Fixed parameters:", __FUNCTION__);
-    params.dump();
+    {
+        Mutex::Autolock lock(wrapper->lock);
+
+        /* Apps poll these while previewing; the vendor string rarely changes */
+        if (wrapper->vendor_parameters == parameters) {
+            gParametersCacheHits++;
+            ret = strdup(wrapper->fixed_parameters.string());
+        } else {
+            gParametersCacheMisses++;
+            ret = fixup_get_parameters(wrapper->id, parameters);
+            if (ret) {
+                wrapper->vendor_parameters.setTo(parameters);
+                wrapper->fixed_parameters.setTo(ret);
+            }
+        }
+    }
 
-    char *ret = strdup(params.flatten().string());
     VENDOR_CALL(device, put_parameters, parameters);
 
     return ret;
@@ -459,8 +1228,7 @@ static void camera_put_parameters(struct camera_device *device, char *params)
     if (!device)
         return;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     if (params)
         free(params);
@@ -472,14 +1240,15 @@ static int camera_send_command(struct camera_device *device,
     if (!device)
         return -EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     if(cmd == CAMERA_CMD_ENABLE_FOCUS_MOVE_MSG) {
-        ALOGV("nardshu: ignoring send_command CAMERA_CMD_ENABLE_FOCUS_MOVE_MSG");
+        TRACE(TRACE_CALLS, "nardshu: ignoring send_command CAMERA_CMD_ENABLE_FOCUS_MOVE_MSG");
         return 0;
     }
 
+    forget_applied_parameters(device);
+
     return VENDOR_CALL(device, send_command, cmd, arg1, arg2);
 }
 
@@ -488,8 +1257,7 @@ static void camera_release(struct camera_device *device)
     if (!device)
         return;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
 
     VENDOR_CALL(device, release);
 }
@@ -499,12 +1267,98 @@ static int camera_dump(struct camera_device *device, int fd)
     if (!device)
         return -EINVAL;
 
-    ALOGV("%s->%08X->%08X", __FUNCTION__, (uintptr_t)device,
-            (uintptr_t)(((wrapper_camera_device_t*)device)->vendor));
+    TRACE_CALL(device);
+
+    dprintf(fd, "CameraWrapper: get_parameters cache hits=%u misses=%u\n",
+            gParametersCacheHits.load(), gParametersCacheMisses.load());
+    dprintf(fd, "CameraWrapper: vendor module loaded in %" PRId64 " ns\n",
+            gVendorModuleLoadTime);
+    dprintf(fd, "CameraWrapper: camera count/info queries saved=%u\n",
+            gVendorQueriesSaved.load());
+    if (CAMERA_ID(device) < MAX_CAMERAS)
+        dprintf(fd, "CameraWrapper: first preview %" PRId64 " ns after open\n",
+                (int64_t)gOpenToPreviewTime[CAMERA_ID(device)]);
+
+    if (gTraceRing) {
+        uint32_t next = gTraceNext.load(std::memory_order_relaxed);
+        uint32_t i = next > TRACE_RING_SIZE ? next - TRACE_RING_SIZE : 0;
+
+        dprintf(fd, "CameraWrapper: last %u vendor calls "
+                "(start_ns camera op duration_ns):\n", next - i);
+        for (; i < next; i++) {
+            const trace_record_t *record = &gTraceRecords[i % TRACE_RING_SIZE];
+            dprintf(fd, "%" PRId64 " %d %s %" PRId64 "\n", record->start,
+                    record->camera_id, camera_op_names[record->op],
+                    record->duration);
+        }
+    }
+
+    dump_op_stats(fd, CAMERA_ID(device));
+
+    if (gFrameStats)
+        dump_frame_stats(fd, (wrapper_camera_device_t *)device);
 
     return VENDOR_CALL(device, dump, fd);
 }
 
+/*
+ * Wrappers for the cameras we know about are allocated once and reused
+ * across opens. Anything else, or a second open of the same camera, gets
+ * one from the heap.
+ */
+static wrapper_camera_device_t gCameraDevices[MAX_CAMERAS];
+
+static wrapper_camera_device_t *get_wrapper_device(int id)
+{
+    wrapper_camera_device_t *wrapper = NULL;
+
+    if (id >= 0 && id < MAX_CAMERAS) {
+        Mutex::Autolock lock(gCameraWrapperLock);
+
+        if (!gCameraDevices[id].in_use) {
+            wrapper = &gCameraDevices[id];
+            wrapper->in_use = true;
+        }
+    }
+
+    if (!wrapper) {
+        wrapper = new (std::nothrow) wrapper_camera_device_t();
+        if (!wrapper)
+            return NULL;
+    } else {
+        wrapper->preallocated = true;
+        memset(&wrapper->base, 0, sizeof(wrapper->base));
+        wrapper->vendor = NULL;
+        wrapper->caf = false;
+        wrapper->vendor_parameters.clear();
+        wrapper->fixed_parameters.clear();
+        wrapper->applied_parameters.clear();
+        wrapper->recording = false;
+        wrapper->notify_cb = NULL;
+        wrapper->data_cb = NULL;
+        wrapper->data_cb_timestamp = NULL;
+        wrapper->get_memory = NULL;
+        wrapper->user = NULL;
+        memset(&wrapper->preview_stats, 0, sizeof(wrapper->preview_stats));
+        memset(&wrapper->video_stats, 0, sizeof(wrapper->video_stats));
+        memset(&wrapper->release_stats, 0, sizeof(wrapper->release_stats));
+    }
+
+    wrapper->id = id;
+    return wrapper;
+}
+
+static void put_wrapper_device(wrapper_camera_device_t *wrapper)
+{
+    if (!wrapper->preallocated) {
+        delete wrapper;
+        return;
+    }
+
+    Mutex::Autolock lock(gCameraWrapperLock);
+    wrapper->in_use = false;
+}
+
 extern "C" void heaptracker_free_leaked_memory(void);
 
 static int camera_device_close(hw_device_t *device)
@@ -512,9 +1366,7 @@ static int camera_device_close(hw_device_t *device)
     int ret = 0;
     wrapper_camera_device_t *wrapper_dev = NULL;
 
-    ALOGV("%s", __FUNCTION__);
-
-    Mutex::Autolock lock(gCameraWrapperLock);
+    TRACE(TRACE_CALLS, "%s", __FUNCTION__);
 
     if (!device) {
         ret = -EINVAL;
@@ -525,10 +1377,10 @@ static int camera_device_close(hw_device_t *device)
 
     wrapper_dev->vendor->common.close((hw_device_t*)wrapper_dev->vendor);
 
-    if (wrapper_dev->base.ops)
-        free(wrapper_dev->base.ops);
+    /* Closing without stop_recording must not leave the profile held */
+    camera_power_recording(wrapper_dev, false);
 
-    free(wrapper_dev);
+    put_wrapper_device(wrapper_dev);
 
 done:
 #ifdef HEAPTRACKER
@@ -541,6 +1393,38 @@ done:
  * implementation of camera_module functions
  *******************************************************************/
 
+static const camera_device_ops_t camera_ops = {
+    .set_preview_window = camera_set_preview_window,
+    .set_callbacks = camera_set_callbacks,
+    .enable_msg_type = camera_enable_msg_type,
+    .disable_msg_type = camera_disable_msg_type,
+    .msg_type_enabled = camera_msg_type_enabled,
+
+    .start_preview = camera_start_preview,
+    .stop_preview = camera_stop_preview,
+    .preview_enabled = camera_preview_enabled,
+    .store_meta_data_in_buffers = camera_store_meta_data_in_buffers,
+
+    .start_recording = camera_start_recording,
+    .stop_recording = camera_stop_recording,
+    .recording_enabled = camera_recording_enabled,
+    .release_recording_frame = camera_release_recording_frame,
+
+    .auto_focus = camera_auto_focus,
+    .cancel_auto_focus = camera_cancel_auto_focus,
+
+    .take_picture = camera_take_picture,
+    .cancel_picture = camera_cancel_picture,
+
+    .set_parameters = camera_set_parameters,
+    .get_parameters = camera_get_parameters,
+    .put_parameters = camera_put_parameters,
+    .send_command = camera_send_command,
+
+    .release = camera_release,
+    .dump = camera_dump,
+};
+
 /* open device handle to one of the cameras
  *
  * assume camera service will keep singleton of each camera
@@ -553,19 +1437,17 @@ static int camera_device_open(const hw_module_t *module, const char *name,
     int rv = 0;
     int num_cameras = 0;
     int cameraid;
+    nsecs_t open_time = systemTime(SYSTEM_TIME_MONOTONIC);
     wrapper_camera_device_t *camera_device = NULL;
-    camera_device_ops_t *camera_ops = NULL;
-
-    Mutex::Autolock lock(gCameraWrapperLock);
 
-    ALOGV("%s", __FUNCTION__);
+    TRACE(TRACE_CALLS, "%s", __FUNCTION__);
 
     if (name != NULL) {
         if (check_vendor_module())
             return -EINVAL;
 
         cameraid = atoi(name);
-        num_cameras = gVendorModule->get_number_of_cameras();
+        num_cameras = camera_get_number_of_cameras();
 
         if (cameraid > num_cameras) {
             ALOGE("camera service provided cameraid out of bounds, "
@@ -575,7 +1457,7 @@ static int camera_device_open(const hw_module_t *module, const char *name,
             goto fail;
         }
 
-        camera_device = (wrapper_camera_device_t*)malloc(sizeof(*camera_device));
+        camera_device = get_wrapper_device(cameraid);
 
         if (!camera_device) {
             ALOGE("camera_device allocation fail");
@@ -583,8 +1465,7 @@ static int camera_device_open(const hw_module_t *module, const char *name,
             goto fail;
         }
 
-        memset(camera_device, 0, sizeof(*camera_device));
-        camera_device->id = cameraid;
+        camera_device->open_time = open_time;
 
         rv = gVendorModule->common.methods->open(
                 (const hw_module_t*)gVendorModule, name,
@@ -595,53 +1476,15 @@ static int camera_device_open(const hw_module_t *module, const char *name,
             goto fail;
         }
 
-        ALOGV("%s: got vendor camera device 0x%08X",
+        TRACE(TRACE_CALLS, "%s: got vendor camera device 0x%08X",
                 __FUNCTION__, (uintptr_t)(camera_device->vendor));
 
-        camera_ops = (camera_device_ops_t*)malloc(sizeof(*camera_ops));
-        if (!camera_ops) {
-            ALOGE("camera_ops allocation fail");
-            rv = -ENOMEM;
-            goto fail;
-        }
-
-        memset(camera_ops, 0, sizeof(*camera_ops));
-
         camera_device->base.common.tag = HARDWARE_DEVICE_TAG;
         camera_device->base.common.version = CAMERA_DEVICE_API_VERSION_1_0;
         camera_device->base.common.module = (hw_module_t *)(module);
         camera_device->base.common.close = camera_device_close;
-        camera_device->base.ops = camera_ops;
-
-        camera_ops->set_preview_window = camera_set_preview_window;
-        camera_ops->set_callbacks = camera_set_callbacks;
-        camera_ops->enable_msg_type = camera_enable_msg_type;
-        camera_ops->disable_msg_type = camera_disable_msg_type;
-        camera_ops->msg_type_enabled = camera_msg_type_enabled;
-
-        camera_ops->start_preview = camera_start_preview;
-        camera_ops->stop_preview = camera_stop_preview;
-        camera_ops->preview_enabled = camera_preview_enabled;
-        camera_ops->store_meta_data_in_buffers = camera_store_meta_data_in_buffers;
-
-        camera_ops->start_recording = camera_start_recording;
-        camera_ops->stop_recording = camera_stop_recording;
-        camera_ops->recording_enabled = camera_recording_enabled;
-        camera_ops->release_recording_frame = camera_release_recording_frame;
-
-        camera_ops->auto_focus = camera_auto_focus;
-        camera_ops->cancel_auto_focus = camera_cancel_auto_focus;
-
-        camera_ops->take_picture = camera_take_picture;
-        camera_ops->cancel_picture = camera_cancel_picture;
-
-        camera_ops->set_parameters = camera_set_parameters;
-        camera_ops->get_parameters = camera_get_parameters;
-        camera_ops->put_parameters = camera_put_parameters;
-        camera_ops->send_command = camera_send_command;
-
-        camera_ops->release = camera_release;
-        camera_ops->dump = camera_dump;
+        /* Shared by every device and never written through */
+        camera_device->base.ops = const_cast<camera_device_ops_t *>(&camera_ops);
 
         *device = &camera_device->base.common;
     }
@@ -650,33 +1493,59 @@ static int camera_device_open(const hw_module_t *module, const char *name,
 
 fail:
     if (camera_device) {
-        free(camera_device);
+        put_wrapper_device(camera_device);
         camera_device = NULL;
     }
-    if (camera_ops) {
-        free(camera_ops);
-        camera_ops = NULL;
-    }
     *device = NULL;
     return rv;
 }
 
 static int camera_get_number_of_cameras(void)
 {
-    ALOGV("%s", __FUNCTION__);
+    TRACE(TRACE_CALLS, "%s", __FUNCTION__);
 
     if (check_vendor_module())
         return 0;
 
-    return gVendorModule->get_number_of_cameras();
+    Mutex::Autolock lock(gCameraInfoLock);
+
+    if (gNumberOfCameras > 0) {
+        gVendorQueriesSaved++;
+        return gNumberOfCameras;
+    }
+
+    int count = gVendorModule->get_number_of_cameras();
+    if (count > 0)
+        gNumberOfCameras = count;
+
+    return count;
 }
 
 static int camera_get_camera_info(int camera_id, struct camera_info *info)
 {
-    ALOGV("%s", __FUNCTION__);
+    int rv;
+
+    TRACE(TRACE_CALLS, "%s", __FUNCTION__);
 
     if (check_vendor_module())
         return 0;
 
-    return gVendorModule->get_camera_info(camera_id, info);
+    if (camera_id < 0 || camera_id >= MAX_CAMERAS)
+        return gVendorModule->get_camera_info(camera_id, info);
+
+    Mutex::Autolock lock(gCameraInfoLock);
+
+    if (gCameraInfoValid[camera_id]) {
+        gVendorQueriesSaved++;
+        *info = gCameraInfo[camera_id];
+        return 0;
+    }
+
+    rv = gVendorModule->get_camera_info(camera_id, info);
+    if (!rv) {
+        gCameraInfo[camera_id] = *info;
+        gCameraInfoValid[camera_id] = true;
+    }
+
+    return rv;
 }
@@ -0,0 +1,50 @@
+#
+# Copyright (C) 2026 The LineageOS Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# The wrapper is built into each binary and wraps MockVendorCamera instead
+# of the vendor module. libcamera_client only exists for the target, so
+# these run on a device, without needing its camera; the tests are built
+# once per fixup variant, as camera.msm8960_test_<variant>.
+LOCAL_PATH:= $(call my-dir)
+
+camera_wrapper_shared_libraries := \
+    liblog libcamera_client libutils libcutils
+
+# $(1): fixup variant, $(2): module name suffix
+define camera-wrapper-test
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := CameraWrapper_test.cpp MockVendorCamera.cpp
+LOCAL_CFLAGS := -DCAMERA_FIXUP_VARIANTS="FIXUP_VARIANT_COMMON|FIXUP_VARIANT_$(1)"
+LOCAL_SHARED_LIBRARIES := $(camera_wrapper_shared_libraries)
+LOCAL_C_INCLUDES := system/media/camera/include
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := camera.msm8960_test_$(2)
+include $(BUILD_NATIVE_TEST)
+endef
+
+$(eval $(call camera-wrapper-test,COMMON,common))
+$(eval $(call camera-wrapper-test,DERP2,derp2))
+$(eval $(call camera-wrapper-test,PREVIEW_SIZE,preview_size))
+
+# With every variant, so that every rule is timed
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := CameraWrapper_benchmark.cpp MockVendorCamera.cpp
+LOCAL_CFLAGS := -DCAMERA_FIXUP_VARIANTS="FIXUP_VARIANT_DERP2|FIXUP_VARIANT_PREVIEW_SIZE"
+LOCAL_SHARED_LIBRARIES := $(camera_wrapper_shared_libraries)
+LOCAL_C_INCLUDES := system/media/camera/include
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := camera.msm8960_benchmark
+include $(BUILD_EXECUTABLE)
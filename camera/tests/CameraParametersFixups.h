@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAMERA_PARAMETERS_FIXUPS_H
+#define CAMERA_PARAMETERS_FIXUPS_H
+
+#include <string.h>
+
+#include <camera/CameraParameters.h>
+#include <utils/String8.h>
+
+#include "../CameraFixups.h"
+
+/*
+ * The fixups as the wrapper made them before rewrite_parameters(), through
+ * CameraParameters, with the DERP2 and PREVIEW_SIZE ifdefs turned into
+ * checks of kFixupVariants. The tests check the rewriter against it and
+ * the benchmark times one against the other. CameraParameters keeps its
+ * keys sorted, so compare its output with the rewriter's after a round
+ * trip through it.
+ */
+static android::String8 camera_parameters_fixup(int id,
+        enum fixup_direction direction, const char *parameters)
+{
+    using android::CameraParameters;
+
+    CameraParameters params;
+    params.unflatten(android::String8(parameters));
+
+    if (direction == FIXUP_GET) {
+        /* Photos: Correct exposed ISO values */
+        if (id == FRONT_CAMERA_ID)
+            params.set(CameraParameters::KEY_SUPPORTED_ISO_MODES, "auto");
+        else if (kFixupVariants & FIXUP_VARIANT_DERP2)
+            params.set(CameraParameters::KEY_SUPPORTED_ISO_MODES,
+                    "auto,ISO100,ISO200,ISO400,ISO800,ISO1600");
+        else
+            params.set(CameraParameters::KEY_SUPPORTED_ISO_MODES,
+                    "auto,ISO100,ISO200,ISO400,ISO800");
+
+        if (kFixupVariants & FIXUP_VARIANT_DERP2) {
+            /* Fix exposure settings */
+            params.set(CameraParameters::KEY_EXPOSURE_COMPENSATION_STEP, "0.5");
+            params.set(CameraParameters::KEY_MIN_EXPOSURE_COMPENSATION, "-4");
+            params.set(CameraParameters::KEY_MAX_EXPOSURE_COMPENSATION, "4");
+
+            /* Sure, it's supported, but not here */
+            params.set(CameraParameters::KEY_VIDEO_SNAPSHOT_SUPPORTED, "false");
+        }
+
+        if (kFixupVariants & FIXUP_VARIANT_PREVIEW_SIZE)
+            params.set(CameraParameters::KEY_PREFERRED_PREVIEW_SIZE_FOR_VIDEO,
+                    id ? "640x480" : "800x480");
+
+        /* Disable all forms of face detection */
+        params.set(CameraParameters::KEY_MAX_NUM_DETECTED_FACES_HW, "0");
+        params.set(CameraParameters::KEY_MAX_NUM_DETECTED_FACES_SW, "0");
+        params.set(CameraParameters::KEY_FACE_DETECTION, "off");
+        params.set(CameraParameters::KEY_SUPPORTED_FACE_DETECTION, "off");
+
+        return params.flatten();
+    }
+
+    /* Map the corrected ISO values to the ones in the HAL */
+    if (params.get(CameraParameters::KEY_ISO_MODE)) {
+        const char *isoMode = params.get(CameraParameters::KEY_ISO_MODE);
+        if (!strcmp(isoMode, "ISO100"))
+            params.set(CameraParameters::KEY_ISO_MODE, "100");
+        else if (!strcmp(isoMode, "ISO200"))
+            params.set(CameraParameters::KEY_ISO_MODE, "200");
+        else if (!strcmp(isoMode, "ISO400"))
+            params.set(CameraParameters::KEY_ISO_MODE, "400");
+        else if (!strcmp(isoMode, "ISO800"))
+            params.set(CameraParameters::KEY_ISO_MODE, "800");
+        else if (!strcmp(isoMode, "ISO1600"))
+            params.set(CameraParameters::KEY_ISO_MODE, "1600");
+    }
+
+    if (kFixupVariants & FIXUP_VARIANT_DERP2) {
+        const char *hint = params.get(CameraParameters::KEY_RECORDING_HINT);
+        const char *zsl = params.get(CameraParameters::KEY_ZSL);
+        bool isVideo = hint && !strcmp(hint, "true");
+        bool isZsl = zsl && !strcmp(zsl, "on");
+
+        /* ZSL: Always set KEY_SAMSUNG_CAMERA_MODE to 1 */
+        if (isZsl)
+            params.set(CameraParameters::KEY_SAMSUNG_CAMERA_MODE, "1");
+
+        if (id == FRONT_CAMERA_ID) {
+            params.set(CameraParameters::KEY_SAMSUNG_CAMERA_MODE,
+                    isVideo ? "1" : "0");
+            params.set(CameraParameters::KEY_SUPPORTED_PREVIEW_SIZES, "960x720");
+        }
+    }
+
+    return params.flatten();
+}
+
+#endif // CAMERA_PARAMETERS_FIXUPS_H
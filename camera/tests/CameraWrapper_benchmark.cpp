@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MockVendorCamera.h"
+
+#define CAMERA_POWER_PROPERTY_GET mock_property_get
+#define CAMERA_POWER_PROPERTY_SET mock_property_set
+#include "../CameraWrapper.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <functional>
+#include <string>
+
+#include "CameraParametersFixups.h"
+#include "ParameterFixtures.h"
+
+/*
+ * Times the parameter fixups of every fixture with rewrite_parameters()
+ * and with the CameraParameters unflatten/set/flatten path it replaced.
+ * Then times get_parameters and set_parameters on the back camera through
+ * the wrapper, against the mock vendor module, both when the wrapper can
+ * take its shortcuts (the vendor string or the settings didn't change) and
+ * when it can't. Last, times take_picture with and without power hints;
+ * boosts are set on the mock's properties, so nothing reaches the power
+ * HAL. Results are key=value lines on stdout, so that runs of different
+ * builds can be diffed.
+ *
+ *   camera.msm8960_benchmark [-n iterations]
+ */
+#define DEFAULT_ITERATIONS 100000
+
+static const struct fixture {
+    const char *name;
+    int id;
+    enum fixup_direction direction;
+    const char *params;
+} kFixtures[] = {
+    { "get_back", BACK_CAMERA_ID, FIXUP_GET, kGetBackParameters },
+    { "get_front", FRONT_CAMERA_ID, FIXUP_GET, kGetFrontParameters },
+    { "set_back", BACK_CAMERA_ID, FIXUP_SET, kSetBackParameters },
+    { "set_front", FRONT_CAMERA_ID, FIXUP_SET, kSetFrontParameters },
+};
+
+static void report(const char *name, int iterations,
+        const std::function<void(int)> &call)
+{
+    nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    for (int i = 0; i < iterations; i++)
+        call(i);
+
+    nsecs_t elapsed = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+
+    printf("%s.calls=%d\n", name, iterations);
+    printf("%s.ns_per_call=%" PRId64 "\n", name,
+            (int64_t)(elapsed / iterations));
+}
+
+static std::string with_zoom(const char *params, const char *zoom)
+{
+    CameraParameters parameters;
+
+    parameters.unflatten(String8(params));
+    parameters.set(CameraParameters::KEY_ZOOM, zoom);
+    return parameters.flatten().string();
+}
+
+int main(int argc, char *argv[])
+{
+    hw_module_t *module = &HAL_MODULE_INFO_SYM.common;
+    int iterations = DEFAULT_ITERATIONS;
+    camera_device_t *device;
+    hw_device_t *dev;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        default:
+            iterations = 0;
+            break;
+        }
+    }
+
+    if (iterations < 1) {
+        fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+        return 1;
+    }
+
+    mock_camera_reset();
+    gPowerHints = false;
+    if (module->methods->open(module, "0", &dev)) {
+        fprintf(stderr, "cannot open the back camera\n");
+        return 1;
+    }
+    device = (camera_device_t *)dev;
+
+    /* Two vendor strings and two settings, differing by the zoom level */
+    const std::string get[2] = {
+        with_zoom(kGetBackParameters, "0"),
+        with_zoom(kGetBackParameters, "4"),
+    };
+    const std::string set[2] = {
+        with_zoom(kSetBackParameters, "0"),
+        with_zoom(kSetBackParameters, "4"),
+    };
+
+    printf("bench.iterations=%d\n", iterations);
+
+    for (const fixture &f : kFixtures) {
+        char name[64];
+
+        snprintf(name, sizeof(name), "rewrite.%s", f.name);
+        report(name, iterations, [&](int) {
+            param_values_t found;
+            free(fixup_parameters(f.id, f.direction, f.params, &found));
+        });
+
+        snprintf(name, sizeof(name), "camera_parameters.%s", f.name);
+        report(name, iterations, [&](int) {
+            camera_parameters_fixup(f.id, f.direction, f.params);
+        });
+    }
+
+    report("get_parameters.unchanged", iterations, [&](int) {
+        device->ops->put_parameters(device, device->ops->get_parameters(device));
+    });
+
+    /* Includes copying the new vendor string into the mock */
+    report("get_parameters.changed", iterations, [&](int i) {
+        gMockCameras[0].parameters = get[i % 2];
+        device->ops->put_parameters(device, device->ops->get_parameters(device));
+    });
+
+    report("set_parameters.unchanged", iterations, [&](int) {
+        device->ops->set_parameters(device, set[0].c_str());
+    });
+
+    report("set_parameters.changed", iterations, [&](int i) {
+        device->ops->set_parameters(device, set[i % 2].c_str());
+    });
+
+    report("take_picture.hints_off", iterations, [&](int) {
+        device->ops->take_picture(device);
+    });
+
+    gPowerHints = true;
+    report("take_picture.hints_on", iterations, [&](int) {
+        device->ops->take_picture(device);
+    });
+    gPowerHints = false;
+
+    printf("get_parameters.cache_hits=%u\n", gParametersCacheHits.load());
+    printf("get_parameters.cache_misses=%u\n", gParametersCacheMisses.load());
+    printf("set_parameters.suppressed=%u\n", gSetParametersSuppressed[0].load());
+    printf("set_parameters.vendor_calls=%d\n", gMockCameras[0].set_calls);
+
+    dev->close(dev);
+    return 0;
+}
@@ -0,0 +1,468 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The wrapper is built into the test, so that its rewriter and caches can
+ * be reached as well as its camera_module_t, and runs against the mock
+ * vendor module and the mock's properties. Android.mk builds it once per
+ * fixup variant; expectations that depend on the variant look at
+ * kFixupVariants.
+ */
+#include "MockVendorCamera.h"
+
+#define CAMERA_POWER_PROPERTY_GET mock_property_get
+#define CAMERA_POWER_PROPERTY_SET mock_property_set
+#include "../CameraWrapper.cpp"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "CameraParametersFixups.h"
+#include "ParameterFixtures.h"
+
+static const bool kDerp2 = kFixupVariants & FIXUP_VARIANT_DERP2;
+static const bool kPreviewSize = kFixupVariants & FIXUP_VARIANT_PREVIEW_SIZE;
+
+static std::string Fixup(int id, enum fixup_direction direction,
+        const char *params)
+{
+    param_values_t found;
+    char *fixed = fixup_parameters(id, direction, params, &found);
+    std::string ret = fixed ? fixed : "";
+
+    free(fixed);
+    return ret;
+}
+
+/* Value of key in a flattened parameter string, "" when absent */
+static std::string Get(const std::string &params, const char *key)
+{
+    CameraParameters parameters;
+
+    parameters.unflatten(String8(params.c_str()));
+    const char *value = parameters.get(key);
+    return value ? value : "";
+}
+
+static std::string Set(const char *params, const char *key, const char *value)
+{
+    CameraParameters parameters;
+
+    parameters.unflatten(String8(params));
+    parameters.set(key, value);
+    return parameters.flatten().string();
+}
+
+TEST(CameraFixupTest, IsoModesAreMappedOnSet)
+{
+    static const char *const kIso[][2] = {
+        { "ISO100", "100" },
+        { "ISO200", "200" },
+        { "ISO400", "400" },
+        { "ISO800", "800" },
+        { "ISO1600", "1600" },
+        { "auto", "auto" },
+    };
+
+    for (const auto &iso : kIso) {
+        std::string params = Set(kSetBackParameters, "iso", iso[0]);
+
+        EXPECT_EQ(iso[1], Get(Fixup(BACK_CAMERA_ID, FIXUP_SET, params.c_str()),
+                "iso")) << iso[0];
+        EXPECT_EQ(iso[1], Get(Fixup(FRONT_CAMERA_ID, FIXUP_SET, params.c_str()),
+                "iso")) << iso[0];
+    }
+}
+
+TEST(CameraFixupTest, SupportedIsoModesOnGet)
+{
+    EXPECT_EQ(kDerp2 ? "auto,ISO100,ISO200,ISO400,ISO800,ISO1600" :
+            "auto,ISO100,ISO200,ISO400,ISO800",
+            Get(Fixup(BACK_CAMERA_ID, FIXUP_GET, kGetBackParameters),
+                    "iso-values"));
+    EXPECT_EQ("auto", Get(Fixup(FRONT_CAMERA_ID, FIXUP_GET, kGetFrontParameters),
+            "iso-values"));
+}
+
+TEST(CameraFixupTest, FaceDetectionIsDisabledOnGet)
+{
+    for (int id : { BACK_CAMERA_ID, FRONT_CAMERA_ID }) {
+        std::string fixed = Fixup(id, FIXUP_GET,
+                id == BACK_CAMERA_ID ? kGetBackParameters : kGetFrontParameters);
+
+        EXPECT_EQ("0", Get(fixed, "max-num-detected-faces-hw"));
+        EXPECT_EQ("0", Get(fixed, "max-num-detected-faces-sw"));
+        EXPECT_EQ("off", Get(fixed, "face-detection"));
+        EXPECT_EQ("off", Get(fixed, "face-detection-values"));
+    }
+}
+
+TEST(CameraFixupTest, ExposureAndVideoSnapshotOnGet)
+{
+    std::string fixed = Fixup(BACK_CAMERA_ID, FIXUP_GET, kGetBackParameters);
+
+    EXPECT_EQ(kDerp2 ? "0.5" : "0.166667",
+            Get(fixed, "exposure-compensation-step"));
+    EXPECT_EQ(kDerp2 ? "-4" : "-12", Get(fixed, "min-exposure-compensation"));
+    EXPECT_EQ(kDerp2 ? "4" : "12", Get(fixed, "max-exposure-compensation"));
+    EXPECT_EQ(kDerp2 ? "false" : "true", Get(fixed, "video-snapshot-supported"));
+}
+
+TEST(CameraFixupTest, PreferredPreviewSizeForVideoOnGet)
+{
+    EXPECT_EQ(kPreviewSize ? "800x480" : "1280x720",
+            Get(Fixup(BACK_CAMERA_ID, FIXUP_GET, kGetBackParameters),
+                    "preferred-preview-size-for-video"));
+    EXPECT_EQ("640x480",
+            Get(Fixup(FRONT_CAMERA_ID, FIXUP_GET, kGetFrontParameters),
+                    "preferred-preview-size-for-video"));
+}
+
+TEST(CameraFixupTest, ZslSetsCameraMode)
+{
+    std::string fixed = Fixup(BACK_CAMERA_ID, FIXUP_SET, kSetBackParameters);
+    EXPECT_EQ(kDerp2 ? "1" : "0", Get(fixed, "cam_mode"));
+
+    std::string params = Set(kSetBackParameters, "zsl", "off");
+    fixed = Fixup(BACK_CAMERA_ID, FIXUP_SET, params.c_str());
+    EXPECT_EQ("0", Get(fixed, "cam_mode"));
+}
+
+TEST(CameraFixupTest, FrontCameraModeFollowsRecordingHint)
+{
+    std::string fixed = Fixup(FRONT_CAMERA_ID, FIXUP_SET, kSetFrontParameters);
+    EXPECT_EQ(kDerp2 ? "1" : "0", Get(fixed, "cam_mode"));
+    EXPECT_EQ(kDerp2 ? "960x720" : "", Get(fixed, "preview-size-values"));
+
+    std::string params = Set(kSetFrontParameters, "recording-hint", "false");
+    params = Set(params.c_str(), "cam_mode", "1");
+    fixed = Fixup(FRONT_CAMERA_ID, FIXUP_SET, params.c_str());
+    EXPECT_EQ(kDerp2 ? "0" : "1", Get(fixed, "cam_mode"));
+}
+
+/* In CameraParameters' order, as camera_parameters_fixup() returns them */
+static std::string Normalize(const std::string &params)
+{
+    CameraParameters parameters;
+
+    parameters.unflatten(String8(params.c_str()));
+    return parameters.flatten().string();
+}
+
+TEST(CameraFixupTest, MatchesCameraParametersPath)
+{
+    static const struct {
+        int id;
+        enum fixup_direction direction;
+        const char *params;
+    } kCases[] = {
+        { BACK_CAMERA_ID, FIXUP_GET, kGetBackParameters },
+        { FRONT_CAMERA_ID, FIXUP_GET, kGetFrontParameters },
+        { BACK_CAMERA_ID, FIXUP_SET, kSetBackParameters },
+        { FRONT_CAMERA_ID, FIXUP_SET, kSetFrontParameters },
+        { FRONT_CAMERA_ID, FIXUP_SET, kSetBackParameters },
+        { BACK_CAMERA_ID, FIXUP_SET, kSetFrontParameters },
+    };
+
+    for (const auto &c : kCases) {
+        EXPECT_EQ(camera_parameters_fixup(c.id, c.direction, c.params).string(),
+                Normalize(Fixup(c.id, c.direction, c.params)))
+                << "camera " << c.id << ", direction " << c.direction;
+    }
+}
+
+/* The front camera always gets DERP2's keys, the back one has no such rule */
+TEST(CameraFixupTest, OtherKeysAreCopiedInOrder)
+{
+    static const char kParams[] =
+            "preview-size=640x480;picture-size=3264x2448;zoom=0;"
+            "effect=none;video-size=1920x1088";
+
+    EXPECT_EQ(kParams, Fixup(BACK_CAMERA_ID, FIXUP_SET, kParams));
+    EXPECT_EQ(0u, Fixup(FRONT_CAMERA_ID, FIXUP_SET, kParams).find(kParams));
+}
+
+TEST(CameraFixupTest, MissingKeysAreAppended)
+{
+    std::string fixed = Fixup(FRONT_CAMERA_ID, FIXUP_GET, "zoom=0");
+
+    EXPECT_EQ(0u, fixed.find("zoom=0;"));
+    EXPECT_EQ("auto", Get(fixed, "iso-values"));
+    EXPECT_EQ("off", Get(fixed, "face-detection"));
+}
+
+/*
+ * Each test opens the back camera through the wrapper module. Power hints
+ * are off unless a test turns them on, and only ever reach the mock's
+ * properties.
+ */
+class CameraWrapperTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        mock_camera_reset();
+        gPowerHints = false;
+        ASSERT_EQ(0, Open("0", &device));
+    }
+
+    void TearDown() override
+    {
+        if (device)
+            device->common.close(&device->common);
+    }
+
+    static int Open(const char *name, camera_device_t **camera)
+    {
+        hw_module_t *module = &HAL_MODULE_INFO_SYM.common;
+        hw_device_t *dev = NULL;
+        int rv = module->methods->open(module, name, &dev);
+
+        *camera = (camera_device_t *)dev;
+        return rv;
+    }
+
+    std::string GetParameters()
+    {
+        char *params = device->ops->get_parameters(device);
+        std::string ret = params ? params : "";
+
+        device->ops->put_parameters(device, params);
+        return ret;
+    }
+
+    int SetParameters(const char *params)
+    {
+        return device->ops->set_parameters(device, params);
+    }
+
+    camera_device_t *device = NULL;
+};
+
+TEST_F(CameraWrapperTest, OpenReusesPreallocatedWrapper)
+{
+    EXPECT_EQ(&gCameraDevices[0].base, device);
+    EXPECT_EQ(1, gMockCameras[0].open_calls);
+
+    device->common.close(&device->common);
+    EXPECT_EQ(1, gMockCameras[0].close_calls);
+
+    ASSERT_EQ(0, Open("0", &device));
+    EXPECT_EQ(&gCameraDevices[0].base, device);
+}
+
+TEST_F(CameraWrapperTest, SecondOpenOfSameCameraUsesHeap)
+{
+    camera_device_t *second;
+
+    ASSERT_EQ(0, Open("0", &second));
+    EXPECT_NE(device, second);
+    EXPECT_NE(&gCameraDevices[1].base, second);
+    EXPECT_EQ(2, gMockCameras[0].open_calls);
+
+    EXPECT_EQ(0, second->ops->set_parameters(second, kSetBackParameters));
+    EXPECT_EQ(1, gMockCameras[0].set_calls);
+
+    second->common.close(&second->common);
+    EXPECT_EQ(1, gMockCameras[0].close_calls);
+}
+
+TEST_F(CameraWrapperTest, OpenOutOfRangeFails)
+{
+    camera_device_t *camera = device;
+
+    EXPECT_EQ(-EINVAL, Open("5", &camera));
+    EXPECT_EQ(NULL, camera);
+}
+
+TEST_F(CameraWrapperTest, FailedVendorOpenReleasesWrapper)
+{
+    camera_device_t *camera = device;
+
+    gMockOpenResult = -ENODEV;
+    EXPECT_EQ(-ENODEV, Open("1", &camera));
+    EXPECT_EQ(NULL, camera);
+
+    gMockOpenResult = 0;
+    ASSERT_EQ(0, Open("1", &camera));
+    EXPECT_EQ(&gCameraDevices[1].base, camera);
+    camera->common.close(&camera->common);
+}
+
+TEST_F(CameraWrapperTest, CameraCountAndInfoAreQueriedOnce)
+{
+    struct camera_info info;
+
+    /* The first open has asked for the count already */
+    EXPECT_EQ(0, HAL_MODULE_INFO_SYM.get_camera_info(FRONT_CAMERA_ID, &info));
+    int count_calls = gMockNumberOfCamerasCalls;
+    int info_calls = gMockCameraInfoCalls;
+    uint32_t saved = gVendorQueriesSaved;
+
+    for (int i = 0; i < 3; i++) {
+        memset(&info, 0, sizeof(info));
+        EXPECT_EQ(MOCK_CAMERAS, HAL_MODULE_INFO_SYM.get_number_of_cameras());
+        EXPECT_EQ(0, HAL_MODULE_INFO_SYM.get_camera_info(FRONT_CAMERA_ID, &info));
+        EXPECT_EQ(CAMERA_FACING_FRONT, info.facing);
+        EXPECT_EQ(270, info.orientation);
+    }
+
+    EXPECT_EQ(count_calls, gMockNumberOfCamerasCalls);
+    EXPECT_EQ(info_calls, gMockCameraInfoCalls);
+    EXPECT_EQ(saved + 6, gVendorQueriesSaved);
+}
+
+TEST_F(CameraWrapperTest, NoCamerasIsNotCached)
+{
+    {
+        Mutex::Autolock lock(gCameraInfoLock);
+        gNumberOfCameras = -1;
+    }
+    int calls = gMockNumberOfCamerasCalls;
+    uint32_t saved = gVendorQueriesSaved;
+
+    gMockNumberOfCameras = 0;
+    EXPECT_EQ(0, HAL_MODULE_INFO_SYM.get_number_of_cameras());
+    EXPECT_EQ(0, HAL_MODULE_INFO_SYM.get_number_of_cameras());
+    EXPECT_EQ(calls + 2, gMockNumberOfCamerasCalls);
+
+    gMockNumberOfCameras = MOCK_CAMERAS;
+    EXPECT_EQ(MOCK_CAMERAS, HAL_MODULE_INFO_SYM.get_number_of_cameras());
+    EXPECT_EQ(MOCK_CAMERAS, HAL_MODULE_INFO_SYM.get_number_of_cameras());
+    EXPECT_EQ(calls + 3, gMockNumberOfCamerasCalls);
+    EXPECT_EQ(saved + 1, gVendorQueriesSaved);
+}
+
+TEST_F(CameraWrapperTest, RecordingIsHeldUntilTheLastStop)
+{
+    camera_device_t *front = NULL;
+
+    gPowerHints = true;
+    ASSERT_EQ(0, Open("1", &front));
+
+    EXPECT_EQ(0, device->ops->start_recording(device));
+    EXPECT_EQ("1", mock_property(CAMERA_RECORDING_PROP));
+    EXPECT_EQ(0, front->ops->start_recording(front));
+
+    device->ops->stop_recording(device);
+    EXPECT_EQ("1", mock_property(CAMERA_RECORDING_PROP));
+
+    /* Closing while recording releases it as well */
+    front->common.close(&front->common);
+    EXPECT_EQ("0", mock_property(CAMERA_RECORDING_PROP));
+}
+
+TEST_F(CameraWrapperTest, GetParametersIsFixedAndCached)
+{
+    uint32_t hits = gParametersCacheHits, misses = gParametersCacheMisses;
+    std::string first = GetParameters();
+
+    EXPECT_EQ(Fixup(BACK_CAMERA_ID, FIXUP_GET, kGetBackParameters), first);
+    EXPECT_EQ(first, GetParameters());
+
+    EXPECT_EQ(misses + 1, gParametersCacheMisses);
+    EXPECT_EQ(hits + 1, gParametersCacheHits);
+    EXPECT_EQ(2, gMockCameras[0].get_calls);
+    EXPECT_EQ(2, gMockCameras[0].put_calls);
+}
+
+TEST_F(CameraWrapperTest, GetParametersFollowsVendorChanges)
+{
+    GetParameters();
+    gMockCameras[0].parameters = Set(kGetBackParameters, "zoom", "12");
+
+    uint32_t misses = gParametersCacheMisses;
+    std::string params = GetParameters();
+
+    EXPECT_EQ(misses + 1, gParametersCacheMisses);
+    EXPECT_EQ("12", Get(params, "zoom"));
+    EXPECT_EQ("off", Get(params, "face-detection"));
+}
+
+TEST_F(CameraWrapperTest, SetParametersForwardsFixedString)
+{
+    EXPECT_EQ(0, SetParameters(kSetBackParameters));
+    EXPECT_EQ(1, gMockCameras[0].set_calls);
+    EXPECT_EQ(Fixup(BACK_CAMERA_ID, FIXUP_SET, kSetBackParameters),
+            gMockCameras[0].last_set);
+    EXPECT_EQ("400", Get(gMockCameras[0].last_set, "iso"));
+}
+
+TEST_F(CameraWrapperTest, RepeatedSetParametersIsSuppressed)
+{
+    uint32_t suppressed = gSetParametersSuppressed[0];
+
+    EXPECT_EQ(0, SetParameters(kSetBackParameters));
+    EXPECT_EQ(0, SetParameters(kSetBackParameters));
+    EXPECT_EQ(1, gMockCameras[0].set_calls);
+    EXPECT_EQ(suppressed + 1, gSetParametersSuppressed[0]);
+
+    std::string params = Set(kSetBackParameters, "zoom", "4");
+    EXPECT_EQ(0, SetParameters(params.c_str()));
+    EXPECT_EQ(2, gMockCameras[0].set_calls);
+}
+
+TEST_F(CameraWrapperTest, SendCommandForwardsNextSetParameters)
+{
+    EXPECT_EQ(0, SetParameters(kSetBackParameters));
+    EXPECT_EQ(0, device->ops->send_command(device, CAMERA_CMD_START_SMOOTH_ZOOM,
+            10, 0));
+    EXPECT_EQ(1, gMockCameras[0].send_command_calls);
+
+    EXPECT_EQ(0, SetParameters(kSetBackParameters));
+    EXPECT_EQ(2, gMockCameras[0].set_calls);
+}
+
+TEST_F(CameraWrapperTest, PreviewAndCaptureForwardNextSetParameters)
+{
+    EXPECT_EQ(0, SetParameters(kSetBackParameters));
+    EXPECT_EQ(0, device->ops->start_preview(device));
+    EXPECT_EQ(0, SetParameters(kSetBackParameters));
+    EXPECT_EQ(2, gMockCameras[0].set_calls);
+
+    EXPECT_EQ(0, device->ops->take_picture(device));
+    EXPECT_EQ(0, SetParameters(kSetBackParameters));
+    EXPECT_EQ(3, gMockCameras[0].set_calls);
+}
+
+TEST_F(CameraWrapperTest, FailedSetParametersIsRetried)
+{
+    gMockCameras[0].set_result = -EINVAL;
+    EXPECT_EQ(-EINVAL, SetParameters(kSetBackParameters));
+
+    gMockCameras[0].set_result = 0;
+    EXPECT_EQ(0, SetParameters(kSetBackParameters));
+    EXPECT_EQ(2, gMockCameras[0].set_calls);
+}
+
+TEST_F(CameraWrapperTest, ContinuousFocusIsTracked)
+{
+    wrapper_camera_device_t *wrapper = (wrapper_camera_device_t *)device;
+
+    EXPECT_EQ(0, SetParameters(kSetBackParameters));
+    EXPECT_EQ(kTrackContinuousFocus, wrapper->caf);
+
+    std::string params = Set(kSetBackParameters, "focus-mode", "infinity");
+    EXPECT_EQ(0, SetParameters(params.c_str()));
+    EXPECT_FALSE(wrapper->caf);
+}
+
+TEST_F(CameraWrapperTest, NullDeviceIsRejected)
+{
+    EXPECT_EQ(-EINVAL, camera_set_parameters(NULL, kSetBackParameters));
+    EXPECT_EQ(NULL, camera_get_parameters(NULL));
+    EXPECT_EQ(-EINVAL, camera_device_close(NULL));
+}
@@ -0,0 +1,352 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <mutex>
+#include <new>
+
+#include <cutils/properties.h>
+#include <hardware/hardware.h>
+
+#include "MockVendorCamera.h"
+#include "ParameterFixtures.h"
+
+MockCamera gMockCameras[MOCK_CAMERAS];
+int gMockOpenResult;
+int gMockNumberOfCameras;
+int gMockNumberOfCamerasCalls;
+int gMockCameraInfoCalls;
+
+struct mock_camera_device {
+    camera_device_t base;
+    MockCamera *camera;
+};
+
+static MockCamera *mock_camera(struct camera_device *device)
+{
+    return ((mock_camera_device *)device)->camera;
+}
+
+static int mock_set_preview_window(struct camera_device *,
+        struct preview_stream_ops *)
+{
+    return 0;
+}
+
+static void mock_set_callbacks(struct camera_device *, camera_notify_callback,
+        camera_data_callback, camera_data_timestamp_callback,
+        camera_request_memory, void *)
+{
+}
+
+static void mock_enable_msg_type(struct camera_device *, int32_t)
+{
+}
+
+static void mock_disable_msg_type(struct camera_device *, int32_t)
+{
+}
+
+static int mock_msg_type_enabled(struct camera_device *, int32_t)
+{
+    return 0;
+}
+
+static int mock_start_preview(struct camera_device *)
+{
+    return 0;
+}
+
+static void mock_stop_preview(struct camera_device *)
+{
+}
+
+static int mock_preview_enabled(struct camera_device *)
+{
+    return 0;
+}
+
+static int mock_store_meta_data_in_buffers(struct camera_device *, int)
+{
+    return 0;
+}
+
+static int mock_start_recording(struct camera_device *)
+{
+    return 0;
+}
+
+static void mock_stop_recording(struct camera_device *)
+{
+}
+
+static int mock_recording_enabled(struct camera_device *)
+{
+    return 0;
+}
+
+static void mock_release_recording_frame(struct camera_device *, const void *)
+{
+}
+
+static int mock_auto_focus(struct camera_device *)
+{
+    return 0;
+}
+
+static int mock_cancel_auto_focus(struct camera_device *)
+{
+    return 0;
+}
+
+static int mock_take_picture(struct camera_device *)
+{
+    return 0;
+}
+
+static int mock_cancel_picture(struct camera_device *)
+{
+    return 0;
+}
+
+static int mock_set_parameters(struct camera_device *device, const char *params)
+{
+    MockCamera *camera = mock_camera(device);
+
+    camera->set_calls++;
+    if (camera->set_result)
+        return camera->set_result;
+
+    camera->last_set = params;
+    return 0;
+}
+
+static char *mock_get_parameters(struct camera_device *device)
+{
+    MockCamera *camera = mock_camera(device);
+
+    camera->get_calls++;
+    return strdup(camera->parameters.c_str());
+}
+
+static void mock_put_parameters(struct camera_device *device, char *params)
+{
+    mock_camera(device)->put_calls++;
+    free(params);
+}
+
+static int mock_send_command(struct camera_device *device, int32_t, int32_t,
+        int32_t)
+{
+    mock_camera(device)->send_command_calls++;
+    return 0;
+}
+
+static void mock_release(struct camera_device *)
+{
+}
+
+static int mock_dump(struct camera_device *, int)
+{
+    return 0;
+}
+
+static camera_device_ops_t mock_ops = {
+    .set_preview_window = mock_set_preview_window,
+    .set_callbacks = mock_set_callbacks,
+    .enable_msg_type = mock_enable_msg_type,
+    .disable_msg_type = mock_disable_msg_type,
+    .msg_type_enabled = mock_msg_type_enabled,
+
+    .start_preview = mock_start_preview,
+    .stop_preview = mock_stop_preview,
+    .preview_enabled = mock_preview_enabled,
+    .store_meta_data_in_buffers = mock_store_meta_data_in_buffers,
+
+    .start_recording = mock_start_recording,
+    .stop_recording = mock_stop_recording,
+    .recording_enabled = mock_recording_enabled,
+    .release_recording_frame = mock_release_recording_frame,
+
+    .auto_focus = mock_auto_focus,
+    .cancel_auto_focus = mock_cancel_auto_focus,
+
+    .take_picture = mock_take_picture,
+    .cancel_picture = mock_cancel_picture,
+
+    .set_parameters = mock_set_parameters,
+    .get_parameters = mock_get_parameters,
+    .put_parameters = mock_put_parameters,
+    .send_command = mock_send_command,
+
+    .release = mock_release,
+    .dump = mock_dump,
+};
+
+static int mock_device_close(hw_device_t *device)
+{
+    mock_camera_device *mock = (mock_camera_device *)device;
+
+    mock->camera->close_calls++;
+    delete mock;
+    return 0;
+}
+
+static int mock_device_open(const hw_module_t *module, const char *name,
+        hw_device_t **device)
+{
+    int id = atoi(name);
+    mock_camera_device *mock;
+
+    if (id < 0 || id >= MOCK_CAMERAS)
+        return -ENODEV;
+
+    gMockCameras[id].open_calls++;
+    if (gMockOpenResult)
+        return gMockOpenResult;
+
+    mock = new (std::nothrow) mock_camera_device();
+    if (!mock)
+        return -ENOMEM;
+
+    mock->base.common.tag = HARDWARE_DEVICE_TAG;
+    mock->base.common.version = CAMERA_DEVICE_API_VERSION_1_0;
+    mock->base.common.module = const_cast<hw_module_t *>(module);
+    mock->base.common.close = mock_device_close;
+    mock->base.ops = &mock_ops;
+    mock->camera = &gMockCameras[id];
+
+    *device = &mock->base.common;
+    return 0;
+}
+
+static int mock_get_number_of_cameras(void)
+{
+    gMockNumberOfCamerasCalls++;
+    return gMockNumberOfCameras;
+}
+
+static int mock_get_camera_info(int camera_id, struct camera_info *info)
+{
+    gMockCameraInfoCalls++;
+    if (camera_id < 0 || camera_id >= MOCK_CAMERAS)
+        return -EINVAL;
+
+    memset(info, 0, sizeof(*info));
+    info->facing = camera_id == 0 ? CAMERA_FACING_BACK : CAMERA_FACING_FRONT;
+    info->orientation = camera_id == 0 ? 90 : 270;
+    info->device_version = CAMERA_DEVICE_API_VERSION_1_0;
+    return 0;
+}
+
+static struct hw_module_methods_t mock_module_methods = {
+    .open = mock_device_open
+};
+
+static camera_module_t mock_module = {
+    .common = {
+         .tag = HARDWARE_MODULE_TAG,
+         .module_api_version = CAMERA_MODULE_API_VERSION_1_0,
+         .hal_api_version = HARDWARE_HAL_API_VERSION,
+         .id = CAMERA_HARDWARE_MODULE_ID,
+         .name = "Mock msm8960 Camera",
+         .author = "The LineageOS Project",
+         .methods = &mock_module_methods,
+         .dso = NULL,
+         .reserved = {0},
+    },
+    .get_number_of_cameras = mock_get_number_of_cameras,
+    .get_camera_info = mock_get_camera_info,
+    .set_callbacks = NULL,
+    .get_vendor_tag_ops = NULL,
+    .open_legacy = NULL,
+    .set_torch_mode = NULL,
+    .init = NULL,
+    .reserved = {0},
+};
+
+extern "C" int hw_get_module_by_class(const char *class_id, const char *inst,
+        const struct hw_module_t **module)
+{
+    if (strcmp(class_id, CAMERA_HARDWARE_MODULE_ID) || strcmp(inst, "vendor"))
+        return -ENOENT;
+
+    *module = &mock_module.common;
+    return 0;
+}
+
+/*
+ * The power boost thread sets properties while tests read them. Both are
+ * made on first use, as the wrapper may load the vendor module from a
+ * static constructor.
+ */
+static std::mutex &mock_properties_lock()
+{
+    static std::mutex lock;
+    return lock;
+}
+
+static std::map<std::string, std::string> &mock_properties()
+{
+    static std::map<std::string, std::string> properties;
+    return properties;
+}
+
+int mock_property_get(const char *key, char *value, const char *default_value)
+{
+    std::lock_guard<std::mutex> lock(mock_properties_lock());
+    auto it = mock_properties().find(key);
+    const char *found = it != mock_properties().end() ? it->second.c_str() :
+            default_value ? default_value : "";
+
+    return snprintf(value, PROPERTY_VALUE_MAX, "%s", found);
+}
+
+int mock_property_set(const char *key, const char *value)
+{
+    std::lock_guard<std::mutex> lock(mock_properties_lock());
+    mock_properties()[key] = value;
+    return 0;
+}
+
+std::string mock_property(const char *key)
+{
+    std::lock_guard<std::mutex> lock(mock_properties_lock());
+    auto it = mock_properties().find(key);
+
+    return it != mock_properties().end() ? it->second : "";
+}
+
+void mock_camera_reset()
+{
+    for (int i = 0; i < MOCK_CAMERAS; i++)
+        gMockCameras[i] = MockCamera();
+
+    gMockCameras[0].parameters = kGetBackParameters;
+    gMockCameras[1].parameters = kGetFrontParameters;
+    gMockOpenResult = 0;
+    gMockNumberOfCameras = MOCK_CAMERAS;
+    gMockNumberOfCamerasCalls = 0;
+    gMockCameraInfoCalls = 0;
+
+    std::lock_guard<std::mutex> lock(mock_properties_lock());
+    mock_properties().clear();
+}
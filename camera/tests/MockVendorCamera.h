@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MOCK_VENDOR_CAMERA_H
+#define MOCK_VENDOR_CAMERA_H
+
+#include <string>
+
+#include <hardware/camera.h>
+
+/*
+ * Stands in for the vendor camera module: hw_get_module_by_class() is
+ * overridden to hand it to the wrapper when it asks for camera.vendor.
+ * Its devices return canned parameter strings from get_parameters and
+ * record what they are given, so tests can check what the wrapper
+ * forwards and how often.
+ */
+#define MOCK_CAMERAS 2
+
+struct MockCamera {
+    /* Returned by get_parameters */
+    std::string parameters;
+    /* Returned by set_parameters, which records its argument otherwise */
+    int set_result;
+    std::string last_set;
+
+    int open_calls;
+    int close_calls;
+    int get_calls;
+    int put_calls;
+    int set_calls;
+    int send_command_calls;
+};
+
+extern MockCamera gMockCameras[MOCK_CAMERAS];
+
+/* Returned by the module's open method; no device is made unless 0 */
+extern int gMockOpenResult;
+/* Returned by the module's get_number_of_cameras */
+extern int gMockNumberOfCameras;
+extern int gMockNumberOfCamerasCalls;
+extern int gMockCameraInfoCalls;
+
+/*
+ * Stand in for property_get() and property_set() for the power hints,
+ * which the tests build the wrapper with, so that no boost or recording
+ * request reaches the power HAL. mock_property() returns what was last
+ * set for key, "" when nothing was.
+ */
+int mock_property_get(const char *key, char *value, const char *default_value);
+int mock_property_set(const char *key, const char *value);
+std::string mock_property(const char *key);
+
+/*
+ * Forget the calls, failures and properties of the previous test, and give
+ * each camera its captured get_parameters string again.
+ */
+void mock_camera_reset();
+
+#endif // MOCK_VENDOR_CAMERA_H
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAMERA_PARAMETER_FIXTURES_H
+#define CAMERA_PARAMETER_FIXTURES_H
+
+/*
+ * Flattened parameter strings in the layout of the msm8960 vendor HAL,
+ * with the keys and value lists it reports for the back and front sensors.
+ * kGet* is what get_parameters returns right after open, kSet* what the
+ * framework sends back once an app has picked its settings.
+ */
+
+static const char kGetBackParameters[] =
+    "ae-bracket-hdr=Off;ae-bracket-hdr-values=Off,HDR,AE-Bracket;"
+    "antibanding=auto;antibanding-values=off,50hz,60hz,auto;"
+    "auto-exposure=frame-average;"
+    "auto-exposure-lock=false;auto-exposure-lock-supported=true;"
+    "auto-exposure-values=frame-average,center-weighted,spot-metering;"
+    "auto-whitebalance-lock=false;auto-whitebalance-lock-supported=true;"
+    "brightness-step=1;cam_mode=0;capture-burst-captures-values=2;"
+    "capture-burst-exposures=;capture-burst-exposures-values=-12,-11,-10,-9,"
+    "-8,-7,-6,-5,-4,-3,-2,-1,0,1,2,3,4,5,6,7,8,9,10,11,12;"
+    "capture-burst-interval=1;capture-burst-interval-max=10;"
+    "capture-burst-interval-min=1;capture-burst-interval-supported=true;"
+    "capture-burst-retroactive=0;capture-burst-retroactive-max=2;"
+    "contrast=5;contrast-step=1;denoise=denoise-off;"
+    "denoise-values=denoise-off,denoise-on;effect=none;"
+    "effect-values=none,mono,negative,solarize,sepia,posterize,whiteboard,"
+    "blackboard,aqua,emboss,sketch,neon;"
+    "exposure-compensation=0;exposure-compensation-step=0.166667;"
+    "face-detection=off;face-detection-values=off,on;"
+    "flash-mode=off;flash-mode-values=off,auto,on,torch;"
+    "focal-length=3.70;focus-areas=(0,0,0,0,0);"
+    "focus-distances=0.100000,0.150000,0.250000;focus-mode=auto;"
+    "focus-mode-values=auto,infinity,macro,continuous-video,"
+    "continuous-picture;"
+    "hfr-size-values=800x480,640x480;histogram=disable;"
+    "histogram-values=enable,disable;horizontal-view-angle=54.8;"
+    "iso=auto;iso-values=auto,ISO_HJR,ISO100,ISO200,ISO400,ISO800,ISO1600;"
+    "jpeg-quality=85;jpeg-thumbnail-height=384;jpeg-thumbnail-quality=90;"
+    "jpeg-thumbnail-size-values=512x288,480x288,432x288,512x384,352x288,0x0;"
+    "jpeg-thumbnail-width=512;lensshade=enable;"
+    "lensshade-values=enable,disable;luma-adaptation=3;"
+    "max-brightness=6;max-contrast=10;max-exposure-compensation=12;"
+    "max-num-detected-faces-hw=2;max-num-detected-faces-sw=0;"
+    "max-num-focus-areas=1;max-num-metering-areas=1;max-saturation=10;"
+    "max-sharpness=30;max-zoom=59;mce=enable;mce-values=enable,disable;"
+    "metering-areas=(0,0,0,0,0);min-exposure-compensation=-12;"
+    "num-snaps-per-shutter=1;overlay-format=265;"
+    "picture-format=jpeg;"
+    "picture-format-values=jpeg,raw,yuv422sp,jps,mpo;"
+    "picture-size=3264x2448;"
+    "picture-size-values=3264x2448,3264x1836,2592x1944,2048x1536,2048x1152,"
+    "1600x1200,1280x960,1280x720,800x480,640x480,320x240;"
+    "power-mode=Normal_Power;power-mode-supported=true;"
+    "preferred-preview-size-for-video=1280x720;"
+    "preview-format=yuv420sp;"
+    "preview-format-values=yuv420sp,yuv420sp-adreno,yuv420p,yuv420p,nv12;"
+    "preview-fps-range=5000,30000;"
+    "preview-fps-range-values=(5000,30000),(5000,15000);"
+    "preview-frame-rate=30;preview-frame-rate-mode=frame-rate-auto;"
+    "preview-frame-rate-modes=frame-rate-auto,frame-rate-fixed;"
+    "preview-frame-rate-values=5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,"
+    "22,23,24,25,26,27,28,29,30;"
+    "preview-size=640x480;"
+    "preview-size-values=1280x720,960x720,800x480,720x480,640x480,576x432,"
+    "480x320,384x288,352x288,320x240,240x160,176x144;"
+    "redeye-reduction=disable;redeye-reduction-values=enable,disable;"
+    "saturation=5;saturation-step=1;scene-detect=off;"
+    "scene-detect-values=off,on;scene-mode=auto;"
+    "scene-mode-values=auto,asd,action,portrait,landscape,night,"
+    "night-portrait,theatre,beach,snow,sunset,steadyphoto,fireworks,sports,"
+    "party,candlelight,backlight,flowers,AR;"
+    "selectable-zone-af=auto;"
+    "selectable-zone-af-values=auto,spot-metering,center-weighted,"
+    "frame-average;"
+    "sharpness=10;sharpness-step=1;skinToneEnhancement=0;"
+    "skinToneEnhancement-values=enable,disable;smooth-zoom-supported=true;"
+    "touch-af-aec=touch-off;touch-af-aec-values=touch-off,touch-on;"
+    "touchAfAec-dx=100;touchAfAec-dy=100;vertical-view-angle=42.5;"
+    "video-frame-format=yuv420sp;video-hfr=off;"
+    "video-hfr-values=off,60,90,120;video-size=1920x1088;"
+    "video-size-values=1920x1088,1280x720,800x480,720x480,640x480,480x320,"
+    "352x288,320x240,176x144;"
+    "video-snapshot-supported=true;video-stabilization-supported=true;"
+    "video-zoom-support=true;whitebalance=auto;"
+    "whitebalance-values=auto,incandescent,fluorescent,daylight,"
+    "cloudy-daylight;"
+    "zoom=0;zoom-ratios=100,102,104,107,109,112,114,117,120,123,125,128,131,"
+    "135,138,141,144,148,151,155,158,162,166,170,174,178,182,186,190,195,200,"
+    "204,209,214,219,224,229,235,240,246,251,257,263,270,276,282,289,296,303,"
+    "310,317,324,332,340,348,356,364,373,381,390;"
+    "zoom-supported=true;zsl=off;zsl-values=off,on";
+
+static const char kGetFrontParameters[] =
+    "antibanding=auto;antibanding-values=off,50hz,60hz,auto;"
+    "auto-exposure=frame-average;"
+    "auto-exposure-lock=false;auto-exposure-lock-supported=true;"
+    "auto-exposure-values=frame-average,center-weighted,spot-metering;"
+    "auto-whitebalance-lock=false;auto-whitebalance-lock-supported=true;"
+    "brightness-step=1;cam_mode=0;contrast=5;contrast-step=1;effect=none;"
+    "effect-values=none,mono,negative,solarize,sepia,posterize,aqua;"
+    "exposure-compensation=0;exposure-compensation-step=0.166667;"
+    "face-detection=off;face-detection-values=off,on;"
+    "flash-mode=off;flash-mode-values=off;"
+    "focal-length=2.73;focus-distances=0.100000,0.150000,0.250000;"
+    "focus-mode=fixed;focus-mode-values=fixed;"
+    "horizontal-view-angle=51.2;iso=auto;iso-values=auto;"
+    "jpeg-quality=85;jpeg-thumbnail-height=384;jpeg-thumbnail-quality=90;"
+    "jpeg-thumbnail-size-values=512x288,480x288,432x288,512x384,352x288,0x0;"
+    "jpeg-thumbnail-width=512;"
+    "max-brightness=6;max-contrast=10;max-exposure-compensation=12;"
+    "max-num-detected-faces-hw=2;max-num-detected-faces-sw=0;"
+    "max-num-focus-areas=0;max-num-metering-areas=0;max-saturation=10;"
+    "max-sharpness=30;max-zoom=0;min-exposure-compensation=-12;"
+    "picture-format=jpeg;picture-format-values=jpeg,raw,yuv422sp;"
+    "picture-size=1280x960;"
+    "picture-size-values=1280x960,1280x720,640x480,320x240;"
+    "preferred-preview-size-for-video=640x480;"
+    "preview-format=yuv420sp;"
+    "preview-format-values=yuv420sp,yuv420sp-adreno,yuv420p,nv12;"
+    "preview-fps-range=5000,30000;"
+    "preview-fps-range-values=(5000,30000),(5000,15000);"
+    "preview-frame-rate=30;preview-frame-rate-values=15,30;"
+    "preview-size=640x480;"
+    "preview-size-values=1280x720,960x720,720x480,640x480,320x240,176x144;"
+    "saturation=5;saturation-step=1;scene-mode=auto;scene-mode-values=auto;"
+    "sharpness=10;sharpness-step=1;smooth-zoom-supported=false;"
+    "vertical-view-angle=39.4;video-frame-format=yuv420sp;"
+    "video-size=1280x720;"
+    "video-size-values=1280x720,720x480,640x480,320x240,176x144;"
+    "video-snapshot-supported=true;video-stabilization-supported=false;"
+    "whitebalance=auto;"
+    "whitebalance-values=auto,incandescent,fluorescent,daylight,"
+    "cloudy-daylight;"
+    "zoom=0;zoom-supported=false;zsl=off;zsl-values=off,on";
+
+/* A still capture in ZSL with continuous focus and a manual ISO */
+static const char kSetBackParameters[] =
+    "antibanding=auto;auto-exposure=frame-average;auto-exposure-lock=false;"
+    "auto-whitebalance-lock=false;cam_mode=0;contrast=5;effect=none;"
+    "exposure-compensation=0;face-detection=off;flash-mode=auto;"
+    "focus-areas=(0,0,0,0,0);focus-mode=continuous-picture;iso=ISO400;"
+    "jpeg-quality=95;jpeg-thumbnail-height=384;jpeg-thumbnail-quality=90;"
+    "jpeg-thumbnail-width=512;metering-areas=(0,0,0,0,0);"
+    "picture-format=jpeg;picture-size=3264x2448;preview-format=yuv420sp;"
+    "preview-fps-range=5000,30000;preview-frame-rate=30;"
+    "preview-size=1280x720;recording-hint=false;rotation=90;saturation=5;"
+    "scene-mode=auto;sharpness=10;video-size=1920x1088;"
+    "video-stabilization=false;whitebalance=auto;zoom=0;zsl=on";
+
+/* A video call: recording hint on, fixed focus */
+static const char kSetFrontParameters[] =
+    "antibanding=auto;auto-exposure=frame-average;auto-exposure-lock=false;"
+    "auto-whitebalance-lock=false;cam_mode=0;contrast=5;effect=none;"
+    "exposure-compensation=0;face-detection=off;flash-mode=off;"
+    "focus-mode=fixed;iso=auto;jpeg-quality=85;jpeg-thumbnail-height=384;"
+    "jpeg-thumbnail-quality=90;jpeg-thumbnail-width=512;picture-format=jpeg;"
+    "picture-size=1280x960;preview-format=yuv420sp;"
+    "preview-fps-range=15000,15000;preview-frame-rate=15;"
+    "preview-size=640x480;recording-hint=true;rotation=270;saturation=5;"
+    "scene-mode=auto;sharpness=10;video-size=640x480;whitebalance=auto;"
+    "zoom=0;zsl=off";
+
+#endif // CAMERA_PARAMETER_FIXTURES_H
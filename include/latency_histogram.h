@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+/*
+ * Latency histograms shared by the power HAL and the camera wrapper, so
+ * that their dumps report the same fields computed the same way. Bucket i
+ * counts samples in [2^i, 2^(i+1)) ns, so percentiles are reported as the
+ * upper bound of the bucket they fall in.
+ */
+#define LATENCY_BUCKETS 32
+
+static inline int latency_bucket(int64_t ns)
+{
+    int bucket;
+
+    if (ns <= 1)
+        return 0;
+
+    bucket = 63 - __builtin_clzll(ns);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+/* Upper bound of the bucket holding the given permille of count samples */
+static inline unsigned long long latency_percentile_ns(
+        const unsigned long *buckets, unsigned long count,
+        unsigned int permille)
+{
+    unsigned long long target =
+            ((unsigned long long)count * permille + 999) / 1000;
+    unsigned long long seen = 0;
+    int i;
+
+    for (i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target)
+            return 2ULL << i;
+    }
+
+    return 2ULL << (LATENCY_BUCKETS - 1);
+}
+
+#endif // LATENCY_HISTOGRAM_H
@@ -148,6 +148,9 @@ PRODUCT_PACKAGES += \
 PRODUCT_PACKAGES += \
     power.msm8960
 
+PRODUCT_PROPERTY_OVERRIDES += \
+    ro.power.hotplug=1
+
 # Ramdisk
 PRODUCT_PACKAGES += \
     fstab.qcom \
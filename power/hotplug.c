@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define LOG_TAG "PowerHAL"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cutils/properties.h>
+#include <utils/Log.h>
+
+#include "clock.h"
+#include "hotplug.h"
+#include "stats.h"
+
+/*
+ * Replaces mpdecision on this dual core SoC: cpu0 is always up and cpu1 is
+ * brought up when the online CPUs are busy and tasks queue up, and taken
+ * down again once both have stayed low for a while. Load comes from the
+ * cpu line of /proc/stat and the run-queue depth from procs_running,
+ * averaged over a couple of samples. Both paths are given by the HAL so
+ * that a fake /proc and sysfs tree can stand in for the real ones.
+ */
+#define HOTPLUG_PROP "ro.power.hotplug"
+/* Wins over HOTPLUG_PROP, for host tests where properties can't be set */
+#define HOTPLUG_ENV "POWER_HOTPLUG"
+/* init only starts it when HOTPLUG_PROP is off, see init.qcom.power.rc */
+#define MPDECISION_SERVICE "mpdecision"
+
+#define SAMPLE_MS 100
+#define SAMPLE_MS_SCREEN_OFF 1000
+
+struct cpu_sample {
+    unsigned long long busy;
+    unsigned long long total;
+    int running;
+};
+
+static atomic_bool enabled = ATOMIC_VAR_INIT(false);
+static atomic_bool cpu1_online = ATOMIC_VAR_INIT(false);
+/* cpu1 stays up until then for a boost, and for how long a boost holds */
+static atomic_llong hold_until_ns = ATOMIC_VAR_INIT(0);
+static atomic_int boost_ms = ATOMIC_VAR_INIT(0);
+/* Set by hotplug_boost() until the hotplug thread picks the boost up */
+static atomic_bool boost_pending = ATOMIC_VAR_INIT(false);
+static int wake_fd = -1;
+
+/* Protects the state below and writes to cpu1's online node */
+static pthread_mutex_t hotplug_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct hotplug_thresholds thresholds;
+static bool screen_on = true;
+static int64_t backoff_until_ns = 0;
+static int stat_fd = -1;
+static int online_fd = -1;
+
+/* Only called from the hotplug thread */
+static int read_stat(struct cpu_sample *sample)
+{
+    /* Room for the intr line, which lists every interrupt */
+    static char buf[16384];
+    unsigned long long v[8];
+    const char *running;
+    ssize_t len;
+    int i;
+
+    len = pread(stat_fd, buf, sizeof(buf) - 1, 0);
+    if (len <= 0)
+        return -1;
+    buf[len] = '\0';
+
+    /* user nice system idle iowait irq softirq steal */
+    memset(v, 0, sizeof(v));
+    if (sscanf(buf, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+            &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) < 4)
+        return -1;
+
+    sample->total = 0;
+    for (i = 0; i < 8; i++)
+        sample->total += v[i];
+    sample->busy = sample->total - v[3] - v[4];
+
+    /* Don't count ourselves, reading this */
+    running = strstr(buf, "\nprocs_running ");
+    sample->running = running ? atoi(running + 15) - 1 : 0;
+    if (sample->running < 0)
+        sample->running = 0;
+
+    return 0;
+}
+
+static bool read_online(void)
+{
+    char c;
+
+    if (pread(online_fd, &c, 1, 0) != 1)
+        return atomic_load(&cpu1_online);
+
+    return c == '1';
+}
+
+/* Leave cpu1 down for backoff_ms. Call with hotplug_lock held */
+static void back_off(int64_t now, const char *why)
+{
+    ALOGI("%s: leaving cpu1 down for %d ms (%s)", __func__,
+            thresholds.backoff_ms, why);
+    backoff_until_ns = now + thresholds.backoff_ms * NSEC_PER_MSEC;
+    stats_count(STATS_HOTPLUG_BACKOFFS, 1);
+}
+
+/*
+ * Whether cpu1 is up now. If it went down without us, thermal core control
+ * or whoever did it wants it down, and gets its way for a while instead of
+ * a fight every sample. Call with hotplug_lock held.
+ */
+static bool refresh_online(int64_t now)
+{
+    bool online = read_online();
+
+    if (!online && atomic_load(&cpu1_online))
+        back_off(now, "taken down");
+    atomic_store(&cpu1_online, online);
+
+    return online;
+}
+
+/* Call with hotplug_lock held */
+static void set_online(bool online, const char *why)
+{
+    char buf[80];
+
+    if (pwrite(online_fd, online ? "1" : "0", 1, 0) != 1) {
+        strerror_r(errno, buf, sizeof(buf));
+        ALOGE("Error taking cpu1 %s: %s\n", online ? "up" : "down", buf);
+        /* Refused, e.g. while thermal keeps it isolated */
+        if (online)
+            back_off(now_ns(), "refused");
+        return;
+    }
+
+    ALOGV("%s: cpu1 %s (%s)", __func__, online ? "up" : "down", why);
+    atomic_store(&cpu1_online, online);
+    stats_count(online ? STATS_HOTPLUG_UP : STATS_HOTPLUG_DOWN, 1);
+}
+
+/* Bring cpu1 up for a boost, unless it already is. Hotplug thread only */
+static void boost_online(void)
+{
+    eventfd_t count;
+    int64_t now;
+
+    eventfd_read(wake_fd, &count);
+    atomic_store(&boost_pending, false);
+
+    pthread_mutex_lock(&hotplug_lock);
+    now = now_ns();
+    if (!refresh_online(now) && now < atomic_load(&hold_until_ns) &&
+            now >= backoff_until_ns) {
+        set_online(true, "boost");
+        stats_count(STATS_HOTPLUG_BOOSTS, 1);
+    }
+    pthread_mutex_unlock(&hotplug_lock);
+}
+
+static void *hotplug_thread(__attribute__((unused)) void *arg)
+{
+    struct pollfd pfd = { .fd = wake_fd, .events = POLLIN };
+    struct cpu_sample prev, cur;
+    int64_t now, next_sample, up_since = 0, down_since = 0;
+    int load, runqueue = 0, interval_ms, timeout_ms;
+    bool online;
+
+    if (read_stat(&prev) < 0)
+        memset(&prev, 0, sizeof(prev));
+    next_sample = now_ns();
+
+    for (;;) {
+        pthread_mutex_lock(&hotplug_lock);
+        interval_ms = screen_on ? SAMPLE_MS : SAMPLE_MS_SCREEN_OFF;
+        pthread_mutex_unlock(&hotplug_lock);
+
+        /* Sleep until the next sample, waking up early for boosts */
+        timeout_ms = (next_sample + interval_ms * NSEC_PER_MSEC - now_ns() +
+                NSEC_PER_MSEC - 1) / NSEC_PER_MSEC;
+        if (timeout_ms > 0 && poll(&pfd, 1, timeout_ms) > 0) {
+            boost_online();
+            continue;
+        }
+        next_sample = now_ns();
+
+        if (read_stat(&cur) < 0 || cur.total <= prev.total)
+            continue;
+
+        load = (cur.busy - prev.busy) * 100 / (cur.total - prev.total);
+        prev = cur;
+        runqueue += (cur.running * 10 - runqueue) / 2;
+
+        pthread_mutex_lock(&hotplug_lock);
+
+        /* Thermal drivers may have taken it down behind our back */
+        now = now_ns();
+        online = refresh_online(now);
+
+        if (!online) {
+            down_since = 0;
+            if (now < backoff_until_ns) {
+                up_since = 0;
+            } else if (thresholds.always_up) {
+                set_online(true, "always up");
+            } else if (load >= thresholds.up_load &&
+                    runqueue >= thresholds.up_runqueue) {
+                if (!up_since)
+                    up_since = now;
+                if (now - up_since >= thresholds.up_ms * NSEC_PER_MSEC) {
+                    set_online(true, "load");
+                    up_since = 0;
+                }
+            } else {
+                up_since = 0;
+            }
+        } else {
+            up_since = 0;
+            if (!thresholds.always_up && load < thresholds.down_load &&
+                    runqueue < thresholds.down_runqueue &&
+                    now >= atomic_load(&hold_until_ns)) {
+                if (!down_since)
+                    down_since = now;
+                if (now - down_since >= thresholds.down_ms * NSEC_PER_MSEC) {
+                    set_online(false, "idle");
+                    down_since = 0;
+                }
+            } else {
+                down_since = 0;
+            }
+        }
+
+        pthread_mutex_unlock(&hotplug_lock);
+    }
+
+    return NULL;
+}
+
+void hotplug_set_state(const struct hotplug_thresholds *t, bool on)
+{
+    if (!atomic_load(&enabled))
+        return;
+
+    pthread_mutex_lock(&hotplug_lock);
+    thresholds = *t;
+    screen_on = on;
+    atomic_store(&boost_ms, t->boost_ms);
+    pthread_mutex_unlock(&hotplug_lock);
+}
+
+/*
+ * Called from the boost paths, which don't take any lock: with cpu1
+ * already up this only extends the hold, otherwise the hotplug thread is
+ * woken up to bring it up.
+ */
+void hotplug_boost(void)
+{
+    int64_t end;
+    int ms;
+
+    if (!atomic_load(&enabled))
+        return;
+
+    ms = atomic_load(&boost_ms);
+    if (!ms)
+        return;
+
+    end = now_ns() + ms * NSEC_PER_MSEC;
+    if (end > atomic_load(&hold_until_ns))
+        atomic_store(&hold_until_ns, end);
+
+    if (atomic_load(&cpu1_online) || atomic_exchange(&boost_pending, true))
+        return;
+
+    eventfd_write(wake_fd, 1);
+}
+
+static bool hotplug_enabled(void)
+{
+    const char *value = getenv(HOTPLUG_ENV);
+
+    if (value)
+        return atoi(value) != 0;
+
+    return property_get_bool(HOTPLUG_PROP, false);
+}
+
+void hotplug_start(const char *stat_path, const char *online_path,
+                   const struct hotplug_thresholds *initial)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    if (!hotplug_enabled())
+        return;
+
+    stat_fd = open(stat_path, O_RDONLY | O_CLOEXEC);
+    online_fd = open(online_path, O_RDWR | O_CLOEXEC);
+    if (stat_fd < 0 || online_fd < 0) {
+        ALOGE("%s: cannot open %s or %s", __func__, stat_path, online_path);
+        goto fail;
+    }
+
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd < 0) {
+        ALOGE("%s: cannot create the wakeup eventfd", __func__);
+        goto fail;
+    }
+
+    /* Nothing is applied until the framework picks a profile */
+    thresholds = *initial;
+    atomic_store(&boost_ms, initial->boost_ms);
+    atomic_store(&cpu1_online, read_online());
+    atomic_store(&enabled, true);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, hotplug_thread, NULL)) {
+        ALOGE("Error starting hotplug thread\n");
+        pthread_attr_destroy(&attr);
+        atomic_store(&enabled, false);
+        goto fail;
+    }
+    pthread_attr_destroy(&attr);
+
+    ALOGI("%s: driving cpu1 hotplug", __func__);
+    return;
+
+fail:
+    if (stat_fd >= 0)
+        close(stat_fd);
+    if (online_fd >= 0)
+        close(online_fd);
+    if (wake_fd >= 0)
+        close(wake_fd);
+    stat_fd = online_fd = wake_fd = -1;
+
+    /* Someone has to bring cpu1 up */
+    ALOGW("%s: falling back to %s", __func__, MPDECISION_SERVICE);
+    stats_count(STATS_HOTPLUG_FALLBACKS, 1);
+    if (property_set("ctl.start", MPDECISION_SERVICE))
+        ALOGE("%s: cannot start %s", __func__, MPDECISION_SERVICE);
+}
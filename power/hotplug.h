@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef POWER_HOTPLUG_H
+#define POWER_HOTPLUG_H
+
+#include <stdbool.h>
+
+/*
+ * When cpu1 comes up and goes down, per profile. Loads are the average
+ * busy percentage of the online CPUs and run-queue depths are in tenths of
+ * a task; each condition has to hold for the given time. always_up keeps
+ * cpu1 up whatever the load, and boosts hold it up for boost_ms, 0
+ * ignoring them. Neither fights thermal: once cpu1 is taken down by anyone
+ * else, it is left down for backoff_ms.
+ */
+struct hotplug_thresholds {
+    int always_up;
+    int up_load;
+    int up_runqueue;
+    int up_ms;
+    int down_load;
+    int down_runqueue;
+    int down_ms;
+    int boost_ms;
+    int backoff_ms;
+};
+
+/*
+ * Start driving cpu1 from the load in stat_path if ro.power.hotplug is
+ * set, in which case init leaves mpdecision stopped. mpdecision is started
+ * instead if the nodes can't be opened or the thread can't run. initial is
+ * followed until the first hotplug_set_state().
+ */
+void hotplug_start(const char *stat_path, const char *online_path,
+                   const struct hotplug_thresholds *initial);
+/* Follow the applied profile; sampling slows down with the screen off */
+void hotplug_set_state(const struct hotplug_thresholds *thresholds,
+                       bool screen_on);
+/* Bring cpu1 up right away for a boost */
+void hotplug_boost(void);
+
+#endif // POWER_HOTPLUG_H
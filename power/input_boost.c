@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define LOG_TAG "PowerHAL"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cutils/properties.h>
+#include <utils/Log.h>
+
+#include "clock.h"
+#include "input_boost.h"
+
+/*
+ * Boosting straight from the touchscreen saves the binder round-trip the
+ * framework's POWER_HINT_INTERACTION goes through on the first frame of a
+ * gesture. It is off unless INPUT_BOOST_PROP is set. By default every
+ * multi-touch device under INPUT_DIR is watched; INPUT_BOOST_DEVICE_PROP
+ * names a single device instead and skips the capability check, so a pipe
+ * or uinput node can be used to feed it events. The matching environment
+ * variables win over both properties, for host tests where they can't be
+ * set.
+ */
+#define INPUT_DIR "/dev/input"
+#define INPUT_BOOST_PROP "persist.power.input_boost"
+#define INPUT_BOOST_DEBOUNCE_PROP "persist.power.input_boost.debounce_ms"
+#define INPUT_BOOST_DEVICE_PROP "persist.power.input_boost.device"
+#define INPUT_BOOST_ENV "POWER_INPUT_BOOST"
+#define INPUT_BOOST_DEVICE_ENV "POWER_INPUT_BOOST_DEVICE"
+
+#define INPUT_BOOST_DEBOUNCE_MS 100
+#define MAX_INPUT_DEVICES 8
+
+#define BITS_PER_LONG (sizeof(unsigned long) * 8)
+#define BITS_TO_LONGS(bits) (((bits) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define test_bit(bit, array) \
+    ((array)[(bit) / BITS_PER_LONG] & (1UL << ((bit) % BITS_PER_LONG)))
+
+static void (*input_boost)(void);
+static int64_t debounce_ns;
+
+static bool is_touchscreen(int fd)
+{
+    unsigned long absbits[BITS_TO_LONGS(ABS_CNT)];
+
+    memset(absbits, 0, sizeof(absbits));
+    if (ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absbits)), absbits) < 0)
+        return false;
+
+    return test_bit(ABS_MT_POSITION_X, absbits) &&
+            test_bit(ABS_MT_POSITION_Y, absbits);
+}
+
+/*
+ * Type B multi-touch devices report a new tracking id for each contact,
+ * others report BTN_TOUCH; either marks the start of a gesture.
+ */
+static bool is_touch_down(const struct input_event *ev)
+{
+    if (ev->type == EV_KEY && ev->code == BTN_TOUCH)
+        return ev->value == 1;
+
+    if (ev->type == EV_ABS && ev->code == ABS_MT_TRACKING_ID)
+        return ev->value >= 0;
+
+    return false;
+}
+
+static void input_boost_handle(int epoll_fd, int fd)
+{
+    static int64_t last_boost_ns;
+    struct input_event ev[16];
+    ssize_t len;
+    size_t i;
+    int64_t now;
+
+    len = read(fd, ev, sizeof(ev));
+    if (len <= 0) {
+        if (len < 0 && (errno == EAGAIN || errno == EINTR))
+            return;
+
+        /* The device went away or the writer closed its end */
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        close(fd);
+        return;
+    }
+
+    for (i = 0; i < len / sizeof(ev[0]); i++) {
+        if (!is_touch_down(&ev[i]))
+            continue;
+
+        now = now_ns();
+        if (now - last_boost_ns >= debounce_ns) {
+            last_boost_ns = now;
+            input_boost();
+        }
+        return;
+    }
+}
+
+static void *input_boost_thread(void *arg)
+{
+    int epoll_fd = (int)(intptr_t)arg;
+    struct epoll_event events[MAX_INPUT_DEVICES];
+    char buf[80];
+    int i, n;
+
+    for (;;) {
+        n = epoll_wait(epoll_fd, events, MAX_INPUT_DEVICES, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            strerror_r(errno, buf, sizeof(buf));
+            ALOGE("Error waiting for input events: %s\n", buf);
+            break;
+        }
+
+        for (i = 0; i < n; i++)
+            input_boost_handle(epoll_fd, events[i].data.fd);
+    }
+
+    close(epoll_fd);
+    return NULL;
+}
+
+static int input_boost_add(int epoll_fd, const char *path, bool probe)
+{
+    struct epoll_event ev = {
+        .events = EPOLLIN,
+    };
+    int fd;
+
+    fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    if (probe && !is_touchscreen(fd)) {
+        close(fd);
+        return -1;
+    }
+
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    ALOGI("%s: boosting on touches from %s", __func__, path);
+    return 0;
+}
+
+static int input_boost_scan(int epoll_fd)
+{
+    char path[PATH_MAX];
+    struct dirent *de;
+    DIR *dir;
+    int count = 0;
+
+    dir = opendir(INPUT_DIR);
+    if (!dir)
+        return 0;
+
+    while ((de = readdir(dir)) && count < MAX_INPUT_DEVICES) {
+        if (strncmp(de->d_name, "event", 5))
+            continue;
+
+        snprintf(path, sizeof(path), INPUT_DIR "/%s", de->d_name);
+        if (input_boost_add(epoll_fd, path, true) == 0)
+            count++;
+    }
+
+    closedir(dir);
+    return count;
+}
+
+static bool input_boost_enabled(void)
+{
+    const char *value = getenv(INPUT_BOOST_ENV);
+
+    if (value)
+        return atoi(value) != 0;
+
+    return property_get_bool(INPUT_BOOST_PROP, false);
+}
+
+static void input_boost_device(char *device)
+{
+    const char *value = getenv(INPUT_BOOST_DEVICE_ENV);
+
+    if (value && strlen(value) < PROPERTY_VALUE_MAX)
+        strcpy(device, value);
+    else
+        property_get(INPUT_BOOST_DEVICE_PROP, device, "");
+}
+
+void input_boost_start(void (*boost)(void))
+{
+    char device[PROPERTY_VALUE_MAX];
+    pthread_attr_t attr;
+    pthread_t thread;
+    int epoll_fd, count;
+
+    if (!input_boost_enabled())
+        return;
+
+    input_boost = boost;
+    debounce_ns = property_get_int32(INPUT_BOOST_DEBOUNCE_PROP,
+            INPUT_BOOST_DEBOUNCE_MS) * NSEC_PER_MSEC;
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        ALOGE("Error creating input boost epoll\n");
+        return;
+    }
+
+    input_boost_device(device);
+    if (device[0])
+        count = input_boost_add(epoll_fd, device, false) == 0;
+    else
+        count = input_boost_scan(epoll_fd);
+
+    if (!count) {
+        ALOGW("%s: no touchscreen found, input boost disabled", __func__);
+        close(epoll_fd);
+        return;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, input_boost_thread,
+            (void *)(intptr_t)epoll_fd)) {
+        ALOGE("Error starting input boost thread\n");
+        close(epoll_fd);
+    }
+    pthread_attr_destroy(&attr);
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef POWER_INPUT_BOOST_H
+#define POWER_INPUT_BOOST_H
+
+/*
+ * Start watching the touchscreen if input boost is enabled; boost is then
+ * called from the input thread on the first touch-down of each gesture.
+ */
+void input_boost_start(void (*boost)(void));
+
+#endif // POWER_INPUT_BOOST_H
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define LOG_TAG "PowerHAL"
+
+#include <stdlib.h>
+
+#include "clock.h"
+#include "plateau.h"
+
+/* Quiet time before probing one step higher, doubled per throttle seen */
+#define PLATEAU_PROBE_NS (60 * NSEC_PER_SEC)
+#define PLATEAU_BACKOFF_MAX 4
+
+int plateau_set_freqs(struct plateau *p, const char *available)
+{
+    char *end;
+    long freq;
+
+    p->count = 0;
+    while (p->count < PLATEAU_MAX_FREQS) {
+        freq = strtol(available, &end, 10);
+        if (end == available)
+            break;
+        available = end;
+
+        /* The kernel lists them in ascending order, keep it that way */
+        if (freq <= 0 || (p->count && freq <= p->freqs[p->count - 1]))
+            continue;
+        p->freqs[p->count++] = freq;
+    }
+
+    return p->count;
+}
+
+/* Index of the highest frequency not above freq, or 0 */
+static int plateau_index(const struct plateau *p, int freq)
+{
+    int i;
+
+    for (i = p->count - 1; i > 0; i--) {
+        if (p->freqs[i] <= freq)
+            break;
+    }
+
+    return i;
+}
+
+void plateau_start(struct plateau *p, int start_freq, int max_freq,
+                   int64_t now_ns)
+{
+    /* Without a frequency table, just hold the starting point */
+    if (!p->count) {
+        p->freqs[0] = start_freq;
+        p->count = 1;
+    }
+
+    p->ceiling = plateau_index(p, max_freq);
+    p->level = plateau_index(p, start_freq);
+    if (p->level > p->ceiling)
+        p->level = p->ceiling;
+    p->throttles = 0;
+    p->stable_since_ns = now_ns;
+}
+
+int plateau_sample(struct plateau *p, int policy_max, int64_t now_ns)
+{
+    unsigned int backoff;
+    int level;
+
+    if (policy_max > 0 && policy_max < p->freqs[p->level]) {
+        /* Settle a step below the limit so the SoC can cool down */
+        level = plateau_index(p, policy_max);
+        if (level > 0 && p->freqs[level] == policy_max)
+            level--;
+
+        p->level = level;
+        p->throttles++;
+        p->stable_since_ns = now_ns;
+        return PLATEAU_BACKED_OFF;
+    }
+
+    backoff = p->throttles < PLATEAU_BACKOFF_MAX ?
+            p->throttles : PLATEAU_BACKOFF_MAX;
+    if (p->level < p->ceiling &&
+            now_ns - p->stable_since_ns >= PLATEAU_PROBE_NS << backoff) {
+        p->level++;
+        p->stable_since_ns = now_ns;
+        return PLATEAU_PROBED;
+    }
+
+    return PLATEAU_HELD;
+}
+
+int plateau_freq(const struct plateau *p)
+{
+    return p->freqs[p->level];
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef POWER_PLATEAU_H
+#define POWER_PLATEAU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PLATEAU_MAX_FREQS 32
+
+/*
+ * Search for the highest CPU frequency that can be held without thermal
+ * throttling. The plateau backs off below any limit the kernel imposes
+ * and is probed one step higher after a quiet period, which doubles with
+ * every throttle seen so that the search settles instead of oscillating.
+ */
+struct plateau {
+    int freqs[PLATEAU_MAX_FREQS];
+    int count;
+    /* Index of the frequency held and of the highest one allowed */
+    int level;
+    int ceiling;
+    unsigned int throttles;
+    int64_t stable_since_ns;
+};
+
+enum {
+    PLATEAU_HELD = 0,
+    PLATEAU_BACKED_OFF,
+    PLATEAU_PROBED,
+};
+
+/* Parse scaling_available_frequencies, returns the number of frequencies */
+int plateau_set_freqs(struct plateau *p, const char *available);
+/* Start searching from start_freq, never going above max_freq */
+void plateau_start(struct plateau *p, int start_freq, int max_freq,
+                   int64_t now_ns);
+/* Feed the maximum frequency the kernel allows right now */
+int plateau_sample(struct plateau *p, int policy_max, int64_t now_ns);
+int plateau_freq(const struct plateau *p);
+
+#endif // POWER_PLATEAU_H
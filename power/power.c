@@ -18,237 +18,1646 @@
 #include <hardware/hardware.h>
 #include <hardware/power.h>
 
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
+#ifdef __BIONIC__
+#define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
+#include <sys/_system_properties.h>
+#endif
+
+#include <cutils/properties.h>
 #include <utils/Log.h>
 
+#include "clock.h"
+#include "hotplug.h"
+#include "input_boost.h"
+#include "plateau.h"
 #include "power.h"
+#include "stats.h"
 
 #define STATE_ON "state=1"
 
 #define CPUFREQ_LIMIT_PATH "/sys/kernel/cpufreq_limit/cpufreq/"
-#define INTERACTIVE_PATH "/sys/devices/system/cpu/cpufreq/interactive/"
+#define CPUFREQ_PATH "/sys/devices/system/cpu/cpufreq/"
+#define INTERACTIVE_PATH CPUFREQ_PATH "interactive/"
+#define CPU0_CPUFREQ_PATH "/sys/devices/system/cpu/cpu0/cpufreq/"
+#define SCALING_GOVERNOR_PATH CPU0_CPUFREQ_PATH "scaling_governor"
+#define POLICY_MAX_FREQ_PATH CPU0_CPUFREQ_PATH "scaling_max_freq"
+#define AVAILABLE_FREQS_PATH CPU0_CPUFREQ_PATH "scaling_available_frequencies"
+#define CPU1_ONLINE_PATH "/sys/devices/system/cpu/cpu1/online"
+#define PROC_STAT_PATH "/proc/stat"
+#define BOOSTPULSE_PATH INTERACTIVE_PATH "boostpulse"
+
+/*
+ * Every sysfs path is resolved against the root named by SYSFS_ROOT_PROP,
+ * and /proc paths against PROCFS_ROOT_PROP, if set, so the HAL can be
+ * pointed at a fake tree. The matching environment variables win over the
+ * properties for processes that can't set them, such as host tests, where
+ * property_get() only ever returns the default. Until sysfs_paths_init()
+ * runs the real paths are used.
+ */
+#define SYSFS_ROOT_PROP "ro.power.sysfs_root"
+#define PROCFS_ROOT_PROP "ro.power.procfs_root"
+#define SYSFS_ROOT_ENV "POWER_SYSFS_ROOT"
+#define PROCFS_ROOT_ENV "POWER_PROCFS_ROOT"
+
+static const char *interactive_path = INTERACTIVE_PATH;
+static const char *boostpulse_path = BOOSTPULSE_PATH;
+static const char *scaling_governor_path = SCALING_GOVERNOR_PATH;
+static const char *cpufreq_path = CPUFREQ_PATH;
+static const char *policy_max_freq_path = POLICY_MAX_FREQ_PATH;
+static const char *available_freqs_path = AVAILABLE_FREQS_PATH;
+static const char *cpu1_online_path = CPU1_ONLINE_PATH;
+static const char *proc_stat_path = PROC_STAT_PATH;
 
 static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
-static int boostpulse_fd = -1;
 
-static int current_power_profile = -1;
-static int requested_power_profile = -1;
+/*
+ * The boost path never takes lock: the governor state, the boostpulse
+ * descriptor and the end of the pulse in flight are published through
+ * atomics, and the current profile is read once per hint.
+ */
+enum {
+    GOVERNOR_UNKNOWN = 0,
+    GOVERNOR_OTHER,
+    GOVERNOR_INTERACTIVE,
+};
+
+static atomic_int governor_state = ATOMIC_VAR_INIT(GOVERNOR_UNKNOWN);
+static atomic_int boostpulse_fd = ATOMIC_VAR_INIT(-1);
+static atomic_llong boostpulse_end_ns = ATOMIC_VAR_INIT(0);
+
+static atomic_int current_power_profile = ATOMIC_VAR_INIT(-1);
+
+enum {
+    NODE_BOOST = 0,
+    NODE_BOOSTPULSE_DURATION,
+    NODE_GO_HISPEED_LOAD,
+    NODE_HISPEED_FREQ,
+    NODE_ABOVE_HISPEED_DELAY,
+    NODE_TIMER_RATE,
+    NODE_IO_IS_BUSY,
+    NODE_MIN_SAMPLE_TIME,
+    NODE_MAX_FREQ_HYSTERESIS,
+    NODE_TARGET_LOADS,
+    NODE_SCALING_MIN_FREQ,
+    NODE_SCALING_MAX_FREQ,
+    NODE_MAX
+};
+
+/*
+ * Tunables are opened on their first write, so that nothing is looked up
+ * before the governor is there, then kept open for the lifetime of the HAL
+ * and rewritten in place with pwrite() at offset 0. A descriptor is only
+ * reopened when a write reports that it went stale, e.g. because the
+ * governor was switched and its sysfs directory recreated.
+ *
+ * The last value successfully written to each node is shadowed so that
+ * writes which would not change anything are skipped; every write wakes
+ * the governor and takes its tunables lock. All accesses happen under lock.
+ */
+struct sysfs_node {
+    const char *path;
+    int fd;
+    bool cached;
+    char value[32];
+};
+
+static struct sysfs_node nodes[NODE_MAX] = {
+    [NODE_BOOST] = { INTERACTIVE_PATH "boost", -1 },
+    [NODE_BOOSTPULSE_DURATION] = { INTERACTIVE_PATH "boostpulse_duration", -1 },
+    [NODE_GO_HISPEED_LOAD] = { INTERACTIVE_PATH "go_hispeed_load", -1 },
+    [NODE_HISPEED_FREQ] = { INTERACTIVE_PATH "hispeed_freq", -1 },
+    [NODE_ABOVE_HISPEED_DELAY] = { INTERACTIVE_PATH "above_hispeed_delay", -1 },
+    [NODE_TIMER_RATE] = { INTERACTIVE_PATH "timer_rate", -1 },
+    [NODE_IO_IS_BUSY] = { INTERACTIVE_PATH "io_is_busy", -1 },
+    [NODE_MIN_SAMPLE_TIME] = { INTERACTIVE_PATH "min_sample_time", -1 },
+    [NODE_MAX_FREQ_HYSTERESIS] = { INTERACTIVE_PATH "max_freq_hysteresis", -1 },
+    [NODE_TARGET_LOADS] = { INTERACTIVE_PATH "target_loads", -1 },
+    [NODE_SCALING_MIN_FREQ] = { CPUFREQ_LIMIT_PATH "scaling_min_freq", -1 },
+    [NODE_SCALING_MAX_FREQ] = { CPUFREQ_LIMIT_PATH "scaling_max_freq", -1 },
+};
+
 
-static int sysfs_write_str(char *path, char *s)
+static int sysfs_node_open(struct sysfs_node *node)
 {
     char buf[80];
-    int len;
-    int ret = 0;
-    int fd;
 
-    fd = open(path, O_WRONLY);
-    if (fd < 0) {
+    if (node->fd >= 0) {
+        close(node->fd);
+        stats_count(STATS_SYSFS_SYSCALLS, 1);
+        stats_count(STATS_SYSFS_REOPENS, 1);
+    }
+
+    node->cached = false;
+    node->fd = open(node->path, O_WRONLY | O_CLOEXEC);
+    stats_count(STATS_SYSFS_SYSCALLS, 1);
+    if (node->fd < 0) {
         strerror_r(errno, buf, sizeof(buf));
-        ALOGE("Error opening %s: %s\n", path, buf);
-        return -1 ;
+        ALOGE("Error opening %s: %s\n", node->path, buf);
+    }
+
+    return node->fd;
+}
+
+static const char *sysfs_path(const char *root, const char *path)
+{
+    char *full;
+
+    if (asprintf(&full, "%s%s", root, path) < 0)
+        return path;
+
+    return full;
+}
+
+static void get_root(const char *env, const char *prop, char *root)
+{
+    const char *value = getenv(env);
+
+    if (value && strlen(value) < PROPERTY_VALUE_MAX)
+        strcpy(root, value);
+    else
+        property_get(prop, root, "");
+}
+
+static void sysfs_paths_init(void)
+{
+    char root[PROPERTY_VALUE_MAX];
+    int i;
+
+    get_root(PROCFS_ROOT_ENV, PROCFS_ROOT_PROP, root);
+    if (root[0]) {
+        ALOGI("%s: using procfs root %s", __func__, root);
+        proc_stat_path = sysfs_path(root, PROC_STAT_PATH);
+    }
+
+    get_root(SYSFS_ROOT_ENV, SYSFS_ROOT_PROP, root);
+    if (!root[0])
+        return;
+
+    ALOGI("%s: using sysfs root %s", __func__, root);
+
+    interactive_path = sysfs_path(root, INTERACTIVE_PATH);
+    boostpulse_path = sysfs_path(root, BOOSTPULSE_PATH);
+    scaling_governor_path = sysfs_path(root, SCALING_GOVERNOR_PATH);
+    cpufreq_path = sysfs_path(root, CPUFREQ_PATH);
+    policy_max_freq_path = sysfs_path(root, POLICY_MAX_FREQ_PATH);
+    available_freqs_path = sysfs_path(root, AVAILABLE_FREQS_PATH);
+    cpu1_online_path = sysfs_path(root, CPU1_ONLINE_PATH);
+
+    for (i = 0; i < NODE_MAX; i++)
+        nodes[i].path = sysfs_path(root, nodes[i].path);
+}
+
+/*
+ * Forget what the nodes hold and close them, to be reopened on their next
+ * write: a recreated governor directory holds new nodes, and the old ones
+ * would only fail the first write after it.
+ */
+static void sysfs_nodes_reset(void)
+{
+    int i;
+
+    for (i = 0; i < NODE_MAX; i++) {
+        nodes[i].cached = false;
+        if (nodes[i].fd >= 0) {
+            close(nodes[i].fd);
+            nodes[i].fd = -1;
+            stats_count(STATS_SYSFS_SYSCALLS, 1);
+        }
+    }
+}
+
+static bool sysfs_fd_is_stale(int err)
+{
+    return err == EBADF || err == ENOENT || err == ENODEV;
+}
+
+static int sysfs_write_str(int id, const char *s)
+{
+    struct sysfs_node *node = &nodes[id];
+    char buf[80];
+    size_t len = strlen(s);
+    bool reopened = false;
+
+    if (node->cached && !strcmp(node->value, s)) {
+        stats_count(STATS_SYSFS_WRITES_SKIPPED, 1);
+        return 0;
+    }
+
+    if (node->fd < 0) {
+        if (sysfs_node_open(node) < 0)
+            return -1;
+        reopened = true;
     }
 
-    len = write(fd, s, strlen(s));
-    if (len < 0) {
+    while (stats_count(STATS_SYSFS_SYSCALLS, 1),
+            pwrite(node->fd, s, len, 0) < 0) {
+        if (!reopened && sysfs_fd_is_stale(errno)) {
+            if (sysfs_node_open(node) < 0)
+                return -1;
+            reopened = true;
+            continue;
+        }
+
         strerror_r(errno, buf, sizeof(buf));
-        ALOGE("Error writing to %s: %s\n", path, buf);
-        ret = -1;
+        ALOGE("Error writing to %s: %s\n", node->path, buf);
+        node->cached = false;
+        return -1;
     }
 
-    close(fd);
+    if (!reopened)
+        stats_count(STATS_SYSFS_SYSCALLS_SAVED, 2);
+
+    node->cached = len < sizeof(node->value);
+    if (node->cached)
+        memcpy(node->value, s, len + 1);
 
-    return ret;
+    return 0;
 }
 
-static int sysfs_write_int(char *path, int value)
+static int sysfs_write_int(int id, int value)
 {
     char buf[80];
     snprintf(buf, 80, "%d", value);
-    return sysfs_write_str(path, buf);
+    return sysfs_write_str(id, buf);
 }
 
 static bool check_governor(void)
 {
     struct stat s;
-    int err = stat(INTERACTIVE_PATH, &s);
+    int err = stat(interactive_path, &s);
     if (err != 0) return false;
     if (S_ISDIR(s.st_mode)) return true;
     return false;
 }
 
-static int is_profile_valid(int profile)
+static int boostpulse_open(void)
 {
-    return profile >= 0 && profile < PROFILE_MAX;
+    int fd = atomic_load(&boostpulse_fd);
+    int new_fd;
+
+    if (fd >= 0)
+        return fd;
+
+    new_fd = open(boostpulse_path, O_WRONLY | O_CLOEXEC);
+    if (new_fd < 0)
+        return -1;
+
+    /* Another hint may have raced us to it */
+    if (!atomic_compare_exchange_strong(&boostpulse_fd, &fd, new_fd)) {
+        close(new_fd);
+        return fd;
+    }
+
+    return new_fd;
 }
 
-static void power_init(__attribute__((unused)) struct power_module *module)
+/*
+ * The boostpulse descriptor is never closed while the HAL is loaded, as a
+ * concurrent hint could still be writing to it. A stale one is instead
+ * replaced in place by a fresh descriptor for the same node.
+ */
+static void boostpulse_reopen(void)
 {
-    ALOGI("%s", __func__);
+    int fd = atomic_load(&boostpulse_fd);
+    int new_fd;
+
+    if (fd < 0)
+        return;
+
+    new_fd = open(boostpulse_path, O_WRONLY | O_CLOEXEC);
+    if (new_fd < 0)
+        return;
+
+    if (dup3(new_fd, fd, O_CLOEXEC) >= 0)
+        stats_count(STATS_BOOSTPULSE_REOPENS, 1);
+    close(new_fd);
 }
 
-static int boostpulse_open()
+/*
+ * Same as check_governor(), but also refreshes the state seen by the boost
+ * path and resets the tunables whenever the interactive directory
+ * appeared or was recreated since the last call, as the governor may have
+ * come back with its default values. Call with lock held.
+ */
+static bool refresh_governor_locked(bool *reset)
 {
-    pthread_mutex_lock(&lock);
-    if (boostpulse_fd < 0) {
-        boostpulse_fd = open(INTERACTIVE_PATH "boostpulse", O_WRONLY);
+    static ino_t governor_ino;
+    struct stat s;
+
+    if (stat(interactive_path, &s) != 0 || !S_ISDIR(s.st_mode)) {
+        governor_ino = 0;
+        atomic_store(&governor_state, GOVERNOR_OTHER);
+        return false;
     }
-    pthread_mutex_unlock(&lock);
 
-    return boostpulse_fd;
+    if (s.st_ino != governor_ino) {
+        sysfs_nodes_reset();
+        boostpulse_reopen();
+        governor_ino = s.st_ino;
+        if (reset)
+            *reset = true;
+    }
+
+    atomic_store(&governor_state, GOVERNOR_INTERACTIVE);
+    return true;
 }
 
-static void power_set_interactive(__attribute__((unused)) struct power_module *module, int on)
+/*
+ * Once the governor watcher is running it keeps governor_state up to date,
+ * so the entry points no longer need to stat the governor directory.
+ */
+static atomic_bool governor_watched = ATOMIC_VAR_INIT(false);
+
+static bool check_governor_locked(void)
 {
-    if (!is_profile_valid(current_power_profile)) {
-        ALOGD("%s: no power profile selected yet", __func__);
-        return;
+    int state = atomic_load(&governor_state);
+
+    if (atomic_load(&governor_watched) && state != GOVERNOR_UNKNOWN)
+        return state == GOVERNOR_INTERACTIVE;
+
+    return refresh_governor_locked(NULL);
+}
+
+static int is_profile_valid(int profile)
+{
+    return profile >= 0 && profile < PROFILE_MAX;
+}
+
+/*
+ * Boost windows raise scaling_min_freq to a level for a given time, see
+ * boost_window(). The highest level with a window in effect applies.
+ */
+enum {
+    BOOST_NONE = 0,
+    BOOST_HISPEED,
+    BOOST_MAX_FREQ,
+    BOOST_LEVEL_MAX
+};
+
+/* Last applied screen, video encode and boost state, protected by lock */
+static bool screen_on = true;
+static bool video_encode_on = false;
+static int boost_level = BOOST_NONE;
+
+/* Frequency held in PROFILE_SUSTAINED_PERFORMANCE, protected by lock */
+static struct plateau plateau;
+
+/*
+ * Program every tunable for the given profile, taking the screen and video
+ * encode state into account. Nodes already holding the right value are
+ * skipped by sysfs_write_str(). Call with lock held.
+ */
+static void apply_power_state(int profile)
+{
+    int timer_rate, io_is_busy, min_freq, max_freq;
+
+    if (video_encode_on) {
+        timer_rate = VID_ENC_TIMER_RATE;
+        io_is_busy = VID_ENC_IO_IS_BUSY;
+    } else {
+        timer_rate = screen_on ? profiles[profile].timer_rate :
+                profiles[profile].timer_rate_off;
+        io_is_busy = profiles[profile].io_is_busy;
     }
 
-    // break out early if governor is not interactive
-    if (!check_governor()) return;
+    max_freq = profile == PROFILE_SUSTAINED_PERFORMANCE ?
+            plateau_freq(&plateau) : profiles[profile].scaling_max_freq;
+
+    /* A boost raises the floor, within the ceiling; the modes ignore it */
+    min_freq = profiles[profile].scaling_min_freq;
+    if (boost_level != BOOST_NONE && profile < PROFILE_MAX) {
+        if (boost_level == BOOST_MAX_FREQ)
+            min_freq = max_freq;
+        else if (min_freq < profiles[profile].hispeed_freq)
+            min_freq = profiles[profile].hispeed_freq;
+    }
+    if (min_freq > max_freq)
+        min_freq = max_freq;
+
+    sysfs_write_int(NODE_BOOST,
+                    profiles[profile].boost);
+    sysfs_write_int(NODE_BOOSTPULSE_DURATION,
+                    profiles[profile].boostpulse_duration);
+    sysfs_write_int(NODE_GO_HISPEED_LOAD, screen_on ?
+                    profiles[profile].go_hispeed_load :
+                    profiles[profile].go_hispeed_load_off);
+    sysfs_write_int(NODE_HISPEED_FREQ, screen_on ?
+                    profiles[profile].hispeed_freq :
+                    profiles[profile].hispeed_freq_off);
+    sysfs_write_str(NODE_ABOVE_HISPEED_DELAY,
+                    profiles[profile].above_hispeed_delay);
+    sysfs_write_int(NODE_TIMER_RATE, timer_rate);
+    sysfs_write_int(NODE_IO_IS_BUSY, io_is_busy);
+    sysfs_write_int(NODE_MIN_SAMPLE_TIME,
+                    profiles[profile].min_sample_time);
+    sysfs_write_int(NODE_MAX_FREQ_HYSTERESIS,
+                    profiles[profile].max_freq_hysteresis);
+    sysfs_write_str(NODE_TARGET_LOADS, screen_on ?
+                    profiles[profile].target_loads :
+                    profiles[profile].target_loads_off);
+    sysfs_write_int(NODE_SCALING_MIN_FREQ, min_freq);
+    sysfs_write_int(NODE_SCALING_MAX_FREQ, max_freq);
+}
+
+/*
+ * Profile, screen and video encode changes are not applied from the binder
+ * thread requesting them. The caller only records the state it wants and
+ * kicks the worker thread, which commits the newest requested state under
+ * lock; requests arriving while a commit is in progress are folded into
+ * the next one. Lock ordering is lock, then request_lock.
+ */
+struct power_state {
+    int profile;
+    bool screen_on;
+    bool video_encode_on;
+    /* Requested by the camera HAL, see camera_recording_trigger() */
+    bool camera_recording;
+    int boost;
+    /* Requested with hints, they override profile while on */
+    bool low_power;
+    bool sustained_performance;
+};
+
+static pthread_mutex_t request_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct power_state requested_state = {
+    .profile = -1,
+    .screen_on = true,
+    .video_encode_on = false,
+    .camera_recording = false,
+    .boost = BOOST_NONE,
+    .low_power = false,
+    .sustained_performance = false,
+};
+/* Requests queued since the last commit, and when the oldest one came in */
+static unsigned int request_depth;
+static int64_t request_since_ns;
+
+static atomic_int request_fd = ATOMIC_VAR_INIT(-1);
+static int governor_watch_fd = -1;
+
+/*
+ * End of the window in effect for each boost level. Written under
+ * request_lock, read without it to merge requests that end no later.
+ */
+static atomic_llong boost_end_ns[BOOST_LEVEL_MAX];
+/* Armed for the earliest end of a window in effect */
+static int boost_timer_fd = -1;
+/* Ticks every PLATEAU_SAMPLE_MS while in PROFILE_SUSTAINED_PERFORMANCE */
+static int sustained_timer_fd = -1;
 
+/*
+ * Sustained performance holds the plateau found by sampling the policy
+ * maximum, which thermal throttling lowers below the limit we set, every
+ * PLATEAU_SAMPLE_MS from the worker thread. Call with lock held.
+ */
+#define PLATEAU_SAMPLE_MS 2000
+
+static void sustained_timer_set(bool on)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
     if (on) {
-        sysfs_write_int(INTERACTIVE_PATH "hispeed_freq",
-                        profiles[current_power_profile].hispeed_freq);
-        sysfs_write_int(INTERACTIVE_PATH "go_hispeed_load",
-                        profiles[current_power_profile].go_hispeed_load);
-        sysfs_write_int(INTERACTIVE_PATH "timer_rate",
-                        profiles[current_power_profile].timer_rate);
-        sysfs_write_str(INTERACTIVE_PATH "target_loads",
-                        profiles[current_power_profile].target_loads);
-    } else {
-        sysfs_write_int(INTERACTIVE_PATH "hispeed_freq",
-                        profiles[current_power_profile].hispeed_freq_off);
-        sysfs_write_int(INTERACTIVE_PATH "timer_rate",
-                        profiles[current_power_profile].timer_rate_off);
-        sysfs_write_int(INTERACTIVE_PATH "go_hispeed_load",
-                        profiles[current_power_profile].go_hispeed_load_off);
-        sysfs_write_str(INTERACTIVE_PATH "target_loads",
-                        profiles[current_power_profile].target_loads_off);
+        its.it_value.tv_sec = PLATEAU_SAMPLE_MS / 1000;
+        its.it_value.tv_nsec = PLATEAU_SAMPLE_MS % 1000 * NSEC_PER_MSEC;
+        its.it_interval = its.it_value;
     }
+
+    if (sustained_timer_fd >= 0)
+        timerfd_settime(sustained_timer_fd, 0, &its, NULL);
 }
 
-static void set_power_profile(int profile)
+static void plateau_init(void)
 {
-    if (!is_profile_valid(profile)) {
-        ALOGE("%s: unknown profile: %d", __func__, profile);
+    char buf[PLATEAU_MAX_FREQS * 12];
+    ssize_t len;
+    int fd;
+
+    fd = open(available_freqs_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ALOGW("%s: no frequency table, sustained mode holds hispeed_freq",
+              __func__);
         return;
     }
 
-    // break out early if governor is not interactive
-    if (!check_governor()) return;
+    len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0)
+        return;
+
+    buf[len] = '\0';
+    plateau_set_freqs(&plateau, buf);
+}
+
+static int read_policy_max_freq(void)
+{
+    static int fd = -1;
+    char buf[16];
+    ssize_t len;
+
+    if (fd < 0)
+        fd = open(policy_max_freq_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    len = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (len <= 0)
+        return -1;
+
+    buf[len] = '\0';
+    return atoi(buf);
+}
+
+/* Which of the profiles a state maps to, the modes winning over profile */
+static int effective_profile(const struct power_state *state)
+{
+    /* Battery saver is the user's choice, an app's request comes second */
+    if (state->low_power)
+        return PROFILE_LOW_POWER;
+    if (state->sustained_performance)
+        return PROFILE_SUSTAINED_PERFORMANCE;
+    return state->profile;
+}
+
+/* Call with lock held */
+static void commit_power_state(const struct power_state *state)
+{
+    unsigned long saved = stats_counter(STATS_SYSFS_SYSCALLS_SAVED);
+    unsigned long skipped = stats_counter(STATS_SYSFS_WRITES_SKIPPED);
+    int profile = effective_profile(state);
 
-    if (profile == current_power_profile)
+    screen_on = state->screen_on;
+    video_encode_on = state->video_encode_on || state->camera_recording;
+    boost_level = state->boost;
+
+    if (profile < 0) {
+        ALOGD("%s: no power profile selected yet", __func__);
         return;
+    }
+
+    // break out early if governor is not interactive
+    if (!check_governor_locked()) return;
 
-    ALOGD("%s: setting profile %d", __func__, profile);
+    if (profile != current_power_profile) {
+        ALOGD("%s: setting profile %d", __func__, profile);
+        stats_count(STATS_PROFILE_SWITCHES, 1);
 
-    sysfs_write_int(INTERACTIVE_PATH "boost",
-                    profiles[profile].boost);
-    sysfs_write_int(INTERACTIVE_PATH "boostpulse_duration",
-                    profiles[profile].boostpulse_duration);
-    sysfs_write_int(INTERACTIVE_PATH "go_hispeed_load",
-                    profiles[profile].go_hispeed_load);
-    sysfs_write_int(INTERACTIVE_PATH "hispeed_freq",
-                    profiles[profile].hispeed_freq);
-    sysfs_write_str(INTERACTIVE_PATH "above_hispeed_delay",
-                    profiles[profile].above_hispeed_delay);
-    sysfs_write_int(INTERACTIVE_PATH "timer_rate",
-                    profiles[profile].timer_rate);
-    sysfs_write_int(INTERACTIVE_PATH "io_is_busy",
-                    profiles[profile].io_is_busy);
-    sysfs_write_int(INTERACTIVE_PATH "min_sample_time",
-                    profiles[profile].min_sample_time);
-    sysfs_write_int(INTERACTIVE_PATH "max_freq_hysteresis",
-                    profiles[profile].max_freq_hysteresis);
-    sysfs_write_str(INTERACTIVE_PATH "target_loads",
-                    profiles[profile].target_loads);
-    sysfs_write_int(CPUFREQ_LIMIT_PATH "scaling_min_freq",
-                    profiles[profile].scaling_min_freq);
-    sysfs_write_int(CPUFREQ_LIMIT_PATH "scaling_max_freq",
-                    profiles[profile].scaling_max_freq);
+        if (profile == PROFILE_SUSTAINED_PERFORMANCE)
+            plateau_start(&plateau,
+                    profiles[PROFILE_SUSTAINED_PERFORMANCE].hispeed_freq,
+                    profiles[PROFILE_SUSTAINED_PERFORMANCE].scaling_max_freq,
+                    now_ns());
+        sustained_timer_set(profile == PROFILE_SUSTAINED_PERFORMANCE);
+    }
 
+    apply_power_state(profile);
     current_power_profile = profile;
+    hotplug_set_state(&profiles[profile].hotplug, screen_on);
+
+    ALOGV("%s: saved %lu syscalls (%lu total), skipped %lu writes (%lu total)",
+          __func__,
+          stats_counter(STATS_SYSFS_SYSCALLS_SAVED) - saved,
+          stats_counter(STATS_SYSFS_SYSCALLS_SAVED),
+          stats_counter(STATS_SYSFS_WRITES_SKIPPED) - skipped,
+          stats_counter(STATS_SYSFS_WRITES_SKIPPED));
 }
 
-static void process_video_encode_hint(void *metadata)
+/* Call with lock held */
+static void commit_requested_state(void)
 {
-    int on;
+    struct power_state state;
+    unsigned int depth;
+    int64_t since, latency;
 
-    if (!metadata)
-        return;
+    stats_lock(&request_lock, STATS_LOCK_REQUEST);
+    state = requested_state;
+    depth = request_depth;
+    since = request_since_ns;
+    request_depth = 0;
+    stats_unlock(&request_lock, STATS_LOCK_REQUEST);
 
-    /* Break out early if governor is not interactive */
-    if (!check_governor())
+    commit_power_state(&state);
+
+    if (!depth)
         return;
 
-    on = !strncmp(metadata, STATE_ON, sizeof(STATE_ON));
+    latency = now_ns() - since;
+    stats_commit(depth, latency);
 
-    sysfs_write_int(INTERACTIVE_PATH "timer_rate", on ?
-            VID_ENC_TIMER_RATE :
-            profiles[current_power_profile].timer_rate);
+    ALOGV("%s: committed %u requests in %lld us", __func__, depth,
+          (long long)(latency / NSEC_PER_USEC));
+}
 
-    sysfs_write_int(INTERACTIVE_PATH "io_is_busy", on ?
-            VID_ENC_IO_IS_BUSY :
-            profiles[current_power_profile].io_is_busy);
+/* Call with request_lock held, after updating requested_state */
+static void queue_power_state_locked(void)
+{
+    if (!request_depth++)
+        request_since_ns = now_ns();
 }
 
-static void power_hint(__attribute__((unused)) struct power_module *module,
-                       power_hint_t hint, void *data)
+/* Returns the number of syscalls made on behalf of the caller */
+static unsigned int kick_power_worker(void)
+{
+    int fd = atomic_load(&request_fd);
+    unsigned long syscalls;
+
+    if (fd >= 0 && eventfd_write(fd, 1) == 0)
+        return 1;
+
+    /* No worker thread, apply synchronously */
+    stats_lock(&lock, STATS_LOCK_HAL);
+    syscalls = stats_counter(STATS_SYSFS_SYSCALLS);
+    commit_requested_state();
+    syscalls = stats_counter(STATS_SYSFS_SYSCALLS) - syscalls;
+    stats_unlock(&lock, STATS_LOCK_HAL);
+
+    return syscalls;
+}
+
+static void governor_watch_handle(void)
+{
+    char buf[sizeof(struct inotify_event) + NAME_MAX + 1];
+    bool reset = false;
+    int prev;
+
+    /* Drain the queue, a burst of events needs a single check */
+    while (read(governor_watch_fd, buf, sizeof(buf)) > 0)
+        ;
+
+    stats_lock(&lock, STATS_LOCK_HAL);
+
+    prev = atomic_load(&governor_state);
+    if (refresh_governor_locked(&reset) &&
+            (prev != GOVERNOR_INTERACTIVE || reset)) {
+        ALOGD("%s: interactive governor is back, restoring tunables", __func__);
+        commit_requested_state();
+        stats_count(STATS_GOVERNOR_RESTORES, 1);
+    }
+
+    stats_unlock(&lock, STATS_LOCK_HAL);
+}
+
+/*
+ * Writes to scaling_governor, whether from init or from a tuning app, go
+ * through the VFS and so raise IN_MODIFY on the node. The cpufreq directory
+ * is watched as well for kernels that notify on sysfs directory changes.
+ */
+static int governor_watch_open(void)
 {
     char buf[80];
-    int len;
+    int fd;
 
-    switch (hint) {
-    case POWER_HINT_INTERACTION:
-    case POWER_HINT_LAUNCH:
-    case POWER_HINT_CPU_BOOST:
-        if (!is_profile_valid(current_power_profile)) {
-            ALOGD("%s: no power profile selected yet", __func__);
-            return;
-        }
+    fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (fd < 0) {
+        strerror_r(errno, buf, sizeof(buf));
+        ALOGE("Error creating governor watch: %s\n", buf);
+        return -1;
+    }
+
+    if (inotify_add_watch(fd, scaling_governor_path, IN_MODIFY) < 0) {
+        strerror_r(errno, buf, sizeof(buf));
+        ALOGE("Error watching %s: %s\n", scaling_governor_path, buf);
+        close(fd);
+        return -1;
+    }
+
+    inotify_add_watch(fd, cpufreq_path, IN_CREATE | IN_DELETE);
+
+    return fd;
+}
+
+/*
+ * Pick the highest level with a window in effect and arm the timer for the
+ * first window to end, so that when the last one does the profile's floor
+ * comes back. Returns whether a new state was queued. Call with
+ * request_lock held.
+ */
+static bool boost_schedule_locked(int64_t now)
+{
+    struct itimerspec its;
+    int64_t end, next = 0;
+    int i, level = BOOST_NONE;
+
+    for (i = BOOST_NONE + 1; i < BOOST_LEVEL_MAX; i++) {
+        end = atomic_load(&boost_end_ns[i]);
+        if (end <= now)
+            continue;
+
+        level = i;
+        if (!next || end < next)
+            next = end;
+    }
+
+    /* A zero it_value disarms the timer */
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = next / NSEC_PER_SEC;
+    its.it_value.tv_nsec = next % NSEC_PER_SEC;
+    timerfd_settime(boost_timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+
+    if (requested_state.boost == level)
+        return false;
+
+    requested_state.boost = level;
+    queue_power_state_locked();
+    return true;
+}
+
+static void boost_timer_expire(void)
+{
+    uint64_t expirations;
+
+    read(boost_timer_fd, &expirations, sizeof(expirations));
+
+    stats_lock(&request_lock, STATS_LOCK_REQUEST);
+    boost_schedule_locked(now_ns());
+    stats_unlock(&request_lock, STATS_LOCK_REQUEST);
+}
+
+static void sustained_timer_expire(void)
+{
+    uint64_t expirations;
+    int freq, result;
 
-        if (!profiles[current_power_profile].boostpulse_duration)
-            return;
+    read(sustained_timer_fd, &expirations, sizeof(expirations));
+
+    stats_lock(&lock, STATS_LOCK_HAL);
+
+    if (current_power_profile != PROFILE_SUSTAINED_PERFORMANCE ||
+            !check_governor_locked()) {
+        stats_unlock(&lock, STATS_LOCK_HAL);
+        return;
+    }
+
+    freq = read_policy_max_freq();
+    result = plateau_sample(&plateau, freq, now_ns());
+    if (result != PLATEAU_HELD) {
+        ALOGI("%s: %s to %d kHz (policy max %d kHz)", __func__,
+              result == PLATEAU_BACKED_OFF ? "backing off" : "probing up",
+              plateau_freq(&plateau), freq);
+        stats_count(result == PLATEAU_BACKED_OFF ?
+                STATS_PLATEAU_THROTTLES : STATS_PLATEAU_PROBES, 1);
+        apply_power_state(PROFILE_SUSTAINED_PERFORMANCE);
+    }
+
+    stats_unlock(&lock, STATS_LOCK_HAL);
+}
 
-        // break out early if governor is not interactive
-        if (!check_governor()) return;
+static void *power_worker_thread(void *arg)
+{
+    int epoll_fd = (int)(intptr_t)arg;
+    struct epoll_event events[4];
+    eventfd_t count;
+    char buf[80];
+    int i, n;
 
-        if (boostpulse_open() >= 0) {
-            snprintf(buf, sizeof(buf), "%d", 1);
-            len = write(boostpulse_fd, &buf, sizeof(buf));
-            if (len < 0) {
-                strerror_r(errno, buf, sizeof(buf));
-                ALOGE("Error writing to boostpulse: %s\n", buf);
+    for (;;) {
+        n = epoll_wait(epoll_fd, events, sizeof(events) / sizeof(events[0]), -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            strerror_r(errno, buf, sizeof(buf));
+            ALOGE("Error waiting for power events: %s\n", buf);
+            break;
+        }
 
-                pthread_mutex_lock(&lock);
-                close(boostpulse_fd);
-                boostpulse_fd = -1;
-                pthread_mutex_unlock(&lock);
+        for (i = 0; i < n; i++) {
+            if (events[i].data.fd == governor_watch_fd) {
+                governor_watch_handle();
+            } else if (events[i].data.fd == sustained_timer_fd) {
+                sustained_timer_expire();
+            } else if (events[i].data.fd == boost_timer_fd) {
+                boost_timer_expire();
+                stats_lock(&lock, STATS_LOCK_HAL);
+                commit_requested_state();
+                stats_unlock(&lock, STATS_LOCK_HAL);
+            } else if (events[i].data.fd == atomic_load(&request_fd)) {
+                eventfd_read(events[i].data.fd, &count);
+                stats_lock(&lock, STATS_LOCK_HAL);
+                commit_requested_state();
+                stats_unlock(&lock, STATS_LOCK_HAL);
             }
         }
-        break;
-    case POWER_HINT_SET_PROFILE:
-        pthread_mutex_lock(&lock);
-        set_power_profile(*(int32_t *)data);
-        pthread_mutex_unlock(&lock);
-        break;
-    case POWER_HINT_VIDEO_ENCODE:
-        pthread_mutex_lock(&lock);
-        process_video_encode_hint(data);
-        pthread_mutex_unlock(&lock);
-        break;
-    default:
-        break;
     }
+
+    /* Fall back to applying requests from the caller */
+    atomic_store(&request_fd, -1);
+    atomic_store(&governor_watched, false);
+    return NULL;
+}
+
+static int power_worker_add(int epoll_fd, int fd)
+{
+    struct epoll_event ev = {
+        .events = EPOLLIN,
+        .data.fd = fd,
+    };
+
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void power_worker_start(void)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+    char buf[80];
+    int epoll_fd, fd;
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        strerror_r(errno, buf, sizeof(buf));
+        ALOGE("Error creating power worker: %s\n", buf);
+        return;
+    }
+
+    fd = governor_watch_open();
+    if (fd >= 0 && power_worker_add(epoll_fd, fd) == 0) {
+        governor_watch_fd = fd;
+        stats_lock(&lock, STATS_LOCK_HAL);
+        atomic_store(&governor_watched, true);
+        refresh_governor_locked(NULL);
+        stats_unlock(&lock, STATS_LOCK_HAL);
+    } else if (fd >= 0) {
+        close(fd);
+    }
+
+    fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd >= 0 && power_worker_add(epoll_fd, fd) == 0) {
+        atomic_store(&request_fd, fd);
+    } else if (fd >= 0) {
+        close(fd);
+    }
+
+    fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd >= 0 && power_worker_add(epoll_fd, fd) == 0) {
+        boost_timer_fd = fd;
+    } else if (fd >= 0) {
+        close(fd);
+    }
+
+    fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd >= 0 && power_worker_add(epoll_fd, fd) == 0) {
+        sustained_timer_fd = fd;
+    } else if (fd >= 0) {
+        close(fd);
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, power_worker_thread,
+            (void *)(intptr_t)epoll_fd)) {
+        ALOGE("Error starting power worker thread\n");
+        atomic_store(&request_fd, -1);
+        atomic_store(&governor_watched, false);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+/*
+ * Profiles can be overridden at runtime from PROFILES_CONFIG_PATH without
+ * rebuilding the HAL. The file is made of one section per profile, each
+ * listing the power_profile fields to override, e.g.
+ *
+ *   [balanced]
+ *   target_loads = 80 1134000:90
+ *   scaling_max_freq = 1458000
+ *   hotplug.up_load = 60
+ *
+ * Anything missing or invalid keeps the value compiled into profiles[].
+ */
+#define PROFILES_CONFIG_PATH "/vendor/etc/power_profiles.conf"
+/* Names another file instead, for host tests */
+#define PROFILES_CONFIG_ENV "POWER_PROFILES_CONFIG"
+#define PROFILES_RELOAD_PROP "sys.power.profiles.reload"
+#define PROFILE_STR_MAX 64
+
+static const char *profile_names[PROFILE_COUNT] = {
+    [PROFILE_POWER_SAVE] = "power_save",
+    [PROFILE_BALANCED] = "balanced",
+    [PROFILE_HIGH_PERFORMANCE] = "high_performance",
+    [PROFILE_BIAS_POWER_SAVE] = "bias_power_save",
+    [PROFILE_LOW_POWER] = "low_power",
+    [PROFILE_SUSTAINED_PERFORMANCE] = "sustained_performance",
+};
+
+struct profile_field {
+    const char *name;
+    size_t offset;
+    bool is_str;
+};
+
+#define PROFILE_INT(field) { #field, offsetof(power_profile, field), false }
+#define PROFILE_STR(field) { #field, offsetof(power_profile, field), true }
+
+static const struct profile_field profile_fields[] = {
+    PROFILE_INT(boost),
+    PROFILE_INT(boostpulse_duration),
+    PROFILE_INT(go_hispeed_load),
+    PROFILE_INT(go_hispeed_load_off),
+    PROFILE_INT(hispeed_freq),
+    PROFILE_INT(hispeed_freq_off),
+    PROFILE_INT(timer_rate),
+    PROFILE_INT(timer_rate_off),
+    PROFILE_STR(above_hispeed_delay),
+    PROFILE_INT(io_is_busy),
+    PROFILE_INT(min_sample_time),
+    PROFILE_INT(max_freq_hysteresis),
+    PROFILE_STR(target_loads),
+    PROFILE_STR(target_loads_off),
+    PROFILE_INT(scaling_min_freq),
+    PROFILE_INT(scaling_max_freq),
+    PROFILE_INT(hotplug.always_up),
+    PROFILE_INT(hotplug.up_load),
+    PROFILE_INT(hotplug.up_runqueue),
+    PROFILE_INT(hotplug.up_ms),
+    PROFILE_INT(hotplug.down_load),
+    PROFILE_INT(hotplug.down_runqueue),
+    PROFILE_INT(hotplug.down_ms),
+    PROFILE_INT(hotplug.boost_ms),
+    PROFILE_INT(hotplug.backoff_ms),
+};
+
+/* Compiled-in table, snapshotted before the first load */
+static power_profile default_profiles[PROFILE_COUNT];
+static const char *profiles_config_path = PROFILES_CONFIG_PATH;
+
+static char *trim(char *str)
+{
+    char *end;
+
+    while (isspace((unsigned char)*str))
+        str++;
+
+    end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1]))
+        *--end = '\0';
+
+    return str;
+}
+
+/*
+ * Store value into the field of profile. A string replacing one from an
+ * earlier line of the same file is freed, the compiled-in one of defaults
+ * is left alone.
+ */
+static bool parse_profile_value(const struct profile_field *field,
+                                const char *value, power_profile *profile,
+                                const power_profile *defaults)
+{
+    char **str, *def, *dup;
+    char *end;
+    long v;
+
+    if (field->is_str) {
+        if (!*value || strlen(value) >= PROFILE_STR_MAX ||
+                strspn(value, "0123456789: ") != strlen(value))
+            return false;
+
+        str = (char **)((char *)profile + field->offset);
+        def = *(char **)((const char *)defaults + field->offset);
+        dup = strdup(value);
+        if (!dup)
+            return false;
+
+        if (*str != def)
+            free(*str);
+        *str = dup;
+        return true;
+    }
+
+    errno = 0;
+    v = strtol(value, &end, 10);
+    if (errno || end == value || *end || v < 0 || v > INT_MAX)
+        return false;
+
+    *(int *)((char *)profile + field->offset) = v;
+    return true;
+}
+
+static void parse_profiles(FILE *f, power_profile *table)
+{
+    char line[128];
+    char *key, *value, *eq;
+    int profile = -1;
+    unsigned int lineno = 0;
+    size_t i;
+
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        key = trim(line);
+
+        if (!*key || *key == '#')
+            continue;
+
+        if (*key == '[') {
+            value = strchr(key, ']');
+            if (value)
+                *value = '\0';
+
+            for (profile = PROFILE_COUNT - 1; profile >= 0; profile--) {
+                if (!strcmp(key + 1, profile_names[profile]))
+                    break;
+            }
+
+            if (profile < 0)
+                ALOGW("%s:%u: unknown profile %s", profiles_config_path,
+                      lineno, key + 1);
+            continue;
+        }
+
+        eq = strchr(key, '=');
+        if (!eq || profile < 0) {
+            ALOGW("%s:%u: ignoring line", profiles_config_path, lineno);
+            continue;
+        }
+
+        *eq = '\0';
+        key = trim(key);
+        value = trim(eq + 1);
+
+        for (i = 0; i < sizeof(profile_fields) / sizeof(profile_fields[0]); i++) {
+            if (!strcmp(key, profile_fields[i].name))
+                break;
+        }
+
+        if (i == sizeof(profile_fields) / sizeof(profile_fields[0])) {
+            ALOGW("%s:%u: unknown key %s", profiles_config_path, lineno, key);
+        } else if (!parse_profile_value(&profile_fields[i], value,
+                                        &table[profile],
+                                        &default_profiles[profile])) {
+            ALOGW("%s:%u: invalid value for %s, keeping default",
+                  profiles_config_path, lineno, key);
+        }
+    }
+}
+
+static void free_profile_strings(power_profile *table)
+{
+    const struct profile_field *field;
+    char *str, *def;
+    size_t i;
+    int p;
+
+    for (p = 0; p < PROFILE_COUNT; p++) {
+        for (i = 0; i < sizeof(profile_fields) / sizeof(profile_fields[0]); i++) {
+            field = &profile_fields[i];
+            if (!field->is_str)
+                continue;
+
+            str = *(char **)((char *)&table[p] + field->offset);
+            def = *(char **)((char *)&default_profiles[p] + field->offset);
+            if (str != def)
+                free(str);
+        }
+    }
+}
+
+/*
+ * Strings in profiles[] are only ever dereferenced under lock, which also
+ * serializes reloads. The boost path reads boostpulse_duration without it,
+ * a torn update of which is harmless.
+ */
+static void load_power_profiles(void)
+{
+    power_profile table[PROFILE_COUNT];
+    FILE *f;
+
+    memcpy(table, default_profiles, sizeof(table));
+
+    f = fopen(profiles_config_path, "re");
+    if (f) {
+        parse_profiles(f, table);
+        fclose(f);
+        ALOGI("%s: loaded %s", __func__, profiles_config_path);
+    } else if (errno != ENOENT) {
+        ALOGW("%s: cannot open %s, using built-in profiles", __func__,
+              profiles_config_path);
+    }
+
+    stats_lock(&lock, STATS_LOCK_HAL);
+    free_profile_strings(profiles);
+    memcpy(profiles, table, sizeof(profiles));
+    stats_unlock(&lock, STATS_LOCK_HAL);
+}
+
+static void power_profiles_init(void)
+{
+    const char *path = getenv(PROFILES_CONFIG_ENV);
+
+    if (path)
+        profiles_config_path = path;
+
+    memcpy(default_profiles, profiles, sizeof(default_profiles));
+    load_power_profiles();
+}
+
+static void reload_profiles_trigger(__attribute__((unused)) const char *value)
+{
+    load_power_profiles();
+
+    /* Reprogram the tunables that changed for the active profile */
+    stats_lock(&request_lock, STATS_LOCK_REQUEST);
+    queue_power_state_locked();
+    stats_unlock(&request_lock, STATS_LOCK_REQUEST);
+
+    kick_power_worker();
+}
+
+/*
+ * The statistics always go to the same file: the HAL runs in
+ * system_server, which must not be made to create or truncate a file at
+ * a path taken from a property.
+ */
+#define STATS_DUMP_PROP "sys.power.dump"
+#define STATS_DUMP_PATH "/data/system/power_hal_stats"
+
+static void dump_stats_trigger(const char *value)
+{
+    char buf[80];
+    int fd;
+
+    if (!value[0])
+        return;
+
+    fd = open(STATS_DUMP_PATH,
+              O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        strerror_r(errno, buf, sizeof(buf));
+        ALOGE("Error opening %s: %s\n", STATS_DUMP_PATH, buf);
+        return;
+    }
+
+    stats_dump(fd);
+    close(fd);
+}
+
+/*
+ * The camera HAL wrapper in mediaserver asks for performance through
+ * properties. CAMERA_BOOST_PROP is a duration in ms of a boost window
+ * around a capture or focus. CAMERA_RECORDING_PROP is 1 while any camera
+ * records. The wrapper counts recordings across cameras itself, and here
+ * the result is kept apart from the VIDEO_ENCODE hint so that neither one
+ * ends the encode profile the other still needs.
+ */
+#define CAMERA_BOOST_PROP "sys.power.camera.boost"
+#define CAMERA_RECORDING_PROP "sys.power.camera.recording"
+
+static unsigned int boost_window(int level, int64_t now, int64_t duration_ns);
+
+static void camera_boost_trigger(const char *value)
+{
+    int ms = atoi(value);
+
+    if (ms <= 0)
+        return;
+
+    stats_count(STATS_CAMERA_BOOSTS, 1);
+    hotplug_boost();
+    boost_window(BOOST_HISPEED, now_ns(), ms * NSEC_PER_MSEC);
+}
+
+static void camera_recording_trigger(const char *value)
+{
+    bool recording = !strcmp(value, "1");
+    bool queued = false;
+
+    stats_lock(&request_lock, STATS_LOCK_REQUEST);
+    if (requested_state.camera_recording != recording) {
+        requested_state.camera_recording = recording;
+        queue_power_state_locked();
+        queued = true;
+    }
+    stats_unlock(&request_lock, STATS_LOCK_REQUEST);
+
+    if (!queued)
+        return;
+
+    if (recording)
+        stats_count(STATS_CAMERA_RECORDINGS, 1);
+    kick_power_worker();
+}
+
+/*
+ * Tuning and debug actions are triggered through system properties: a
+ * single thread sleeps until any property changes and runs the handler of
+ * each trigger whose property was written to since it last looked.
+ *
+ *   sys.power.profiles.reload  any value, reloads PROFILES_CONFIG_PATH
+ *   sys.power.dump             any value, writes STATS_DUMP_PATH
+ *   sys.power.camera.boost     ms, boosts for a camera capture or focus
+ *   sys.power.camera.recording 0 or 1, whether a camera is recording
+ */
+struct property_trigger {
+    const char *name;
+    void (*handler)(const char *value);
+    const struct prop_info *pi;
+    unsigned int serial;
+};
+
+static struct property_trigger property_triggers[] = {
+    { PROFILES_RELOAD_PROP, reload_profiles_trigger, NULL, 0 },
+    { STATS_DUMP_PROP, dump_stats_trigger, NULL, 0 },
+    { CAMERA_BOOST_PROP, camera_boost_trigger, NULL, 0 },
+    { CAMERA_RECORDING_PROP, camera_recording_trigger, NULL, 0 },
+};
+
+#define NUM_PROPERTY_TRIGGERS \
+    (sizeof(property_triggers) / sizeof(property_triggers[0]))
+
+#ifdef __BIONIC__
+static void *property_watch_thread(__attribute__((unused)) void *arg)
+{
+    char value[PROP_VALUE_MAX];
+    struct property_trigger *t;
+    unsigned int serial = 0;
+    size_t i;
+
+    /* Only react to writes made after the HAL came up */
+    for (i = 0; i < NUM_PROPERTY_TRIGGERS; i++) {
+        t = &property_triggers[i];
+        t->pi = __system_property_find(t->name);
+        if (t->pi)
+            t->serial = __system_property_serial(t->pi);
+    }
+
+    for (;;) {
+        serial = __system_property_wait_any(serial);
+
+        for (i = 0; i < NUM_PROPERTY_TRIGGERS; i++) {
+            t = &property_triggers[i];
+            if (!t->pi)
+                t->pi = __system_property_find(t->name);
+            if (!t->pi || __system_property_serial(t->pi) == t->serial)
+                continue;
+
+            t->serial = __system_property_serial(t->pi);
+            __system_property_read(t->pi, NULL, value);
+            t->handler(value);
+        }
+    }
+
+    return NULL;
+}
+
+static void property_watch_start(void)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, property_watch_thread, NULL))
+        ALOGE("Error starting property watch thread\n");
+    pthread_attr_destroy(&attr);
+}
+#else
+/* Host builds, such as the tests, have no property area to watch */
+static void property_watch_start(void)
+{
+    ALOGI("%s: %zu triggers unavailable on this host", __func__,
+          NUM_PROPERTY_TRIGGERS);
+}
+#endif
+
+/*
+ * Fire a boostpulse unless one is already in effect. now is the time the
+ * hint came in; returns the number of syscalls made.
+ */
+static unsigned int boostpulse(int64_t now)
+{
+    int profile = atomic_load(&current_power_profile);
+    int state = atomic_load(&governor_state);
+    unsigned int syscalls = 0;
+    long long end;
+    char buf[80];
+    int fd;
+
+    /* Every boost brings cpu1 up as well, if the HAL drives hotplug */
+    hotplug_boost();
+
+    if (profile < 0) {
+        ALOGD("%s: no power profile selected yet", __func__);
+        return 0;
+    }
+
+    if (!profiles[profile].boostpulse_duration)
+        return 0;
+
+    if (state == GOVERNOR_UNKNOWN) {
+        state = check_governor() ? GOVERNOR_INTERACTIVE : GOVERNOR_OTHER;
+        atomic_store(&governor_state, state);
+        syscalls++;
+    }
+
+    // break out early if governor is not interactive
+    if (state != GOVERNOR_INTERACTIVE) return syscalls;
+
+    /* Coalesce hints that arrive while a pulse is still in effect */
+    end = atomic_load(&boostpulse_end_ns);
+    if (now < end || !atomic_compare_exchange_strong(&boostpulse_end_ns, &end,
+            now + profiles[profile].boostpulse_duration * NSEC_PER_USEC)) {
+        stats_count(STATS_BOOSTPULSE_COALESCED, 1);
+        return syscalls;
+    }
+
+    if (atomic_load(&boostpulse_fd) < 0)
+        syscalls++;
+
+    fd = boostpulse_open();
+    syscalls++;
+    if (fd >= 0 && pwrite(fd, "1", 1, 0) == 1) {
+        stats_count(STATS_BOOSTPULSE_WRITES, 1);
+        return syscalls;
+    }
+
+    stats_count(STATS_BOOSTPULSE_FAILURES, 1);
+    if (fd >= 0) {
+        strerror_r(errno, buf, sizeof(buf));
+        ALOGE("Error writing to boostpulse: %s\n", buf);
+        boostpulse_reopen();
+        syscalls += 3;
+    }
+
+    /*
+     * Let the next hint retry. The governor is revalidated on the way too,
+     * unless the watcher owns governor_state: it would never see a reason
+     * to put it back and the boost path would stat on every hint.
+     */
+    atomic_store(&boostpulse_end_ns, 0);
+    if (!atomic_load(&governor_watched))
+        atomic_store(&governor_state, GOVERNOR_UNKNOWN);
+
+    return syscalls;
+}
+
+/* Longest window a single boost request gets */
+#define BOOST_MAX_MS 5000
+/* Overrides BOOST_MAX_MS, for host tests */
+#define BOOST_MAX_ENV "POWER_BOOST_MAX_MS"
+
+static int boost_max_ms = BOOST_MAX_MS;
+
+static void boost_max_init(void)
+{
+    const char *value = getenv(BOOST_MAX_ENV);
+
+    if (value && atoi(value) > 0)
+        boost_max_ms = atoi(value);
+}
+
+/*
+ * Boosts longer than a boostpulse hold scaling_min_freq at a level for
+ * duration_ns, merging with the window already in effect for that level;
+ * the worker thread drops the floor again when the last window ends. A
+ * request ending no later than the current window only costs an atomic
+ * read. now is the time the request came in; returns the number of
+ * syscalls made.
+ */
+static unsigned int boost_window(int level, int64_t now, int64_t duration_ns)
+{
+    int64_t end;
+    unsigned int syscalls = 1;
+    bool queued;
+
+    /* The hint-driven modes don't boost, see apply_power_state() */
+    if (atomic_load(&current_power_profile) >= PROFILE_MAX)
+        return 0;
+
+    if (duration_ns > boost_max_ms * NSEC_PER_MSEC)
+        duration_ns = boost_max_ms * NSEC_PER_MSEC;
+    end = now + duration_ns;
+
+    /* Without the worker nothing would end the window, pulse instead */
+    if (boost_timer_fd < 0 || atomic_load(&request_fd) < 0)
+        return boostpulse(now);
+
+    if (end <= atomic_load(&boost_end_ns[level])) {
+        stats_count(STATS_BOOST_WINDOWS_MERGED, 1);
+        return 0;
+    }
+
+    stats_lock(&request_lock, STATS_LOCK_REQUEST);
+    if (end > atomic_load(&boost_end_ns[level]))
+        atomic_store(&boost_end_ns[level], end);
+    queued = boost_schedule_locked(now);
+    stats_unlock(&request_lock, STATS_LOCK_REQUEST);
+
+    stats_count(STATS_BOOST_WINDOWS, 1);
+    if (queued)
+        syscalls += kick_power_worker();
+
+    return syscalls;
+}
+
+/* End the window of a level early, e.g. once an app has launched */
+static unsigned int boost_window_end(int level, int64_t now)
+{
+    unsigned int syscalls = 1;
+    bool queued;
+
+    if (atomic_load(&boost_end_ns[level]) <= now)
+        return 0;
+
+    stats_lock(&request_lock, STATS_LOCK_REQUEST);
+    atomic_store(&boost_end_ns[level], 0);
+    queued = boost_schedule_locked(now);
+    stats_unlock(&request_lock, STATS_LOCK_REQUEST);
+
+    if (queued)
+        syscalls += kick_power_worker();
+
+    return syscalls;
+}
+
+static void input_boost_pulse(void)
+{
+    stats_count(STATS_INPUT_BOOSTS, 1);
+    boostpulse(now_ns());
+}
+
+static void power_init(__attribute__((unused)) struct power_module *module)
+{
+    ALOGI("%s", __func__);
+
+    stats_lock(&lock, STATS_LOCK_HAL);
+    sysfs_paths_init();
+    plateau_init();
+    stats_unlock(&lock, STATS_LOCK_HAL);
+
+    power_profiles_init();
+    boost_max_init();
+    /* The framework starts out balanced, follow it until it says so */
+    hotplug_start(proc_stat_path, cpu1_online_path,
+            &profiles[PROFILE_BALANCED].hotplug);
+    power_worker_start();
+    property_watch_start();
+    input_boost_start(input_boost_pulse);
+}
+
+static void power_set_interactive(__attribute__((unused)) struct power_module *module, int on)
+{
+    int64_t start = now_ns();
+    unsigned int syscalls;
+
+    stats_lock(&request_lock, STATS_LOCK_REQUEST);
+    requested_state.screen_on = on;
+    queue_power_state_locked();
+    stats_unlock(&request_lock, STATS_LOCK_REQUEST);
+
+    syscalls = kick_power_worker();
+
+    stats_hint(STATS_SET_INTERACTIVE, now_ns() - start, syscalls);
+}
+
+static unsigned int set_power_profile(int profile)
+{
+    if (!is_profile_valid(profile)) {
+        ALOGE("%s: unknown profile: %d", __func__, profile);
+        return 0;
+    }
+
+    stats_lock(&request_lock, STATS_LOCK_REQUEST);
+    requested_state.profile = profile;
+    queue_power_state_locked();
+    stats_unlock(&request_lock, STATS_LOCK_REQUEST);
+
+    return kick_power_worker();
+}
+
+static unsigned int process_video_encode_hint(void *metadata)
+{
+    if (!metadata)
+        return 0;
+
+    stats_lock(&request_lock, STATS_LOCK_REQUEST);
+    requested_state.video_encode_on =
+            !strncmp(metadata, STATE_ON, sizeof(STATE_ON));
+    queue_power_state_locked();
+    stats_unlock(&request_lock, STATS_LOCK_REQUEST);
+
+    return kick_power_worker();
+}
+
+/*
+ * LOW_POWER and SUSTAINED_PERFORMANCE data is non-zero to enter the mode
+ * and zero, or none, to leave it; see effective_profile().
+ */
+static unsigned int set_power_mode(bool *mode, void *data)
+{
+    bool on = data && *(int32_t *)data;
+
+    stats_lock(&request_lock, STATS_LOCK_REQUEST);
+    if (*mode == on) {
+        stats_unlock(&request_lock, STATS_LOCK_REQUEST);
+        return 0;
+    }
+    *mode = on;
+    queue_power_state_locked();
+    stats_unlock(&request_lock, STATS_LOCK_REQUEST);
+
+    return kick_power_worker();
+}
+
+/*
+ * The boost hints carry the duration wanted, if any: INTERACTION in ms and
+ * CPU_BOOST in us. Durations covered by the profile's boostpulse are left
+ * to the governor, longer ones also get a window at hispeed_freq. LAUNCH
+ * data is non-zero when an app starts launching and holds the profile's
+ * maximum until it is sent again without data, for LAUNCH_BOOST_MS at most;
+ * values above 1 are taken as a duration in ms.
+ */
+#define LAUNCH_BOOST_MS 2000
+
+static unsigned int boost_hint(int64_t now, int64_t duration_ns)
+{
+    int profile = atomic_load(&current_power_profile);
+    unsigned int syscalls = boostpulse(now);
+
+    if (profile >= 0 && duration_ns >
+            profiles[profile].boostpulse_duration * NSEC_PER_USEC)
+        syscalls += boost_window(BOOST_HISPEED, now, duration_ns);
+
+    return syscalls;
+}
+
+static unsigned int launch_hint(int64_t now, void *data)
+{
+    int value = data ? *(int32_t *)data : 0;
+
+    if (!value)
+        return boost_window_end(BOOST_MAX_FREQ, now);
+
+    return boostpulse(now) + boost_window(BOOST_MAX_FREQ, now,
+            (value > 1 ? value : LAUNCH_BOOST_MS) * NSEC_PER_MSEC);
+}
+
+static void power_hint(__attribute__((unused)) struct power_module *module,
+                       power_hint_t hint, void *data)
+{
+    /* The first clock read is shared with the boost coalescing */
+    int64_t start = now_ns();
+    unsigned int syscalls;
+    int type;
+
+    switch (hint) {
+    case POWER_HINT_INTERACTION:
+        type = STATS_HINT_INTERACTION;
+        syscalls = boost_hint(start,
+                data ? *(int32_t *)data * NSEC_PER_MSEC : 0);
+        break;
+    case POWER_HINT_LAUNCH:
+        type = STATS_HINT_LAUNCH;
+        syscalls = launch_hint(start, data);
+        break;
+    case POWER_HINT_CPU_BOOST:
+        type = STATS_HINT_CPU_BOOST;
+        syscalls = boost_hint(start,
+                data ? *(int32_t *)data * NSEC_PER_USEC : 0);
+        break;
+    case POWER_HINT_SET_PROFILE:
+        type = STATS_HINT_SET_PROFILE;
+        syscalls = set_power_profile(*(int32_t *)data);
+        break;
+    case POWER_HINT_VIDEO_ENCODE:
+        type = STATS_HINT_VIDEO_ENCODE;
+        syscalls = process_video_encode_hint(data);
+        break;
+    case POWER_HINT_LOW_POWER:
+        type = STATS_HINT_LOW_POWER;
+        syscalls = set_power_mode(&requested_state.low_power, data);
+        break;
+    case POWER_HINT_SUSTAINED_PERFORMANCE:
+        type = STATS_HINT_SUSTAINED_PERFORMANCE;
+        syscalls = set_power_mode(&requested_state.sustained_performance,
+                data);
+        break;
+    default:
+        return;
+    }
+
+    /* Don't count the clock reads made for the measurement itself */
+    stats_hint(type, now_ns() - start, syscalls);
 }
 
 static struct hw_module_methods_t power_module_methods = {
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include "hotplug.h"
+
 /* Video encode hint optimisations */
 #define VID_ENC_TIMER_RATE 30000
 #define VID_ENC_IO_IS_BUSY 0
@@ -23,7 +25,16 @@ enum {
     PROFILE_BALANCED,
     PROFILE_HIGH_PERFORMANCE,
     PROFILE_BIAS_POWER_SAVE,
-    PROFILE_MAX
+    PROFILE_MAX,
+
+    /*
+     * Modes entered through POWER_HINT_LOW_POWER and
+     * POWER_HINT_SUSTAINED_PERFORMANCE. They take over from the selected
+     * profile while on, and cannot be picked with POWER_HINT_SET_PROFILE.
+     */
+    PROFILE_LOW_POWER = PROFILE_MAX,
+    PROFILE_SUSTAINED_PERFORMANCE,
+    PROFILE_COUNT
 };
 
 typedef struct governor_settings {
@@ -44,9 +55,10 @@ typedef struct governor_settings {
     char *target_loads_off;
     int scaling_min_freq;
     int scaling_max_freq;
+    struct hotplug_thresholds hotplug;
 } power_profile;
 
-static power_profile profiles[PROFILE_MAX] = {
+static power_profile profiles[PROFILE_COUNT] = {
     [PROFILE_POWER_SAVE] = {
         .boost = 0,
         .boostpulse_duration = 40000,
@@ -64,6 +76,16 @@ static power_profile profiles[PROFILE_MAX] = {
         .target_loads_off = "95 1512000:99",
         .scaling_min_freq = 384000,
         .scaling_max_freq = 1026000,
+        .hotplug = {
+            .up_load = 85,
+            .up_runqueue = 25,
+            .up_ms = 200,
+            .down_load = 50,
+            .down_runqueue = 20,
+            .down_ms = 200,
+            .boost_ms = 500,
+            .backoff_ms = 10000,
+        },
     },
     [PROFILE_BALANCED] = {
         .boost = 0,
@@ -82,6 +104,16 @@ static power_profile profiles[PROFILE_MAX] = {
         .target_loads_off = "95 1512000:99",
         .scaling_min_freq = 384000,
         .scaling_max_freq = 1512000,
+        .hotplug = {
+            .up_load = 70,
+            .up_runqueue = 20,
+            .up_ms = 100,
+            .down_load = 35,
+            .down_runqueue = 15,
+            .down_ms = 500,
+            .boost_ms = 1000,
+            .backoff_ms = 10000,
+        },
     },
     [PROFILE_HIGH_PERFORMANCE] = {
         .boost = 1,
@@ -100,6 +132,17 @@ static power_profile profiles[PROFILE_MAX] = {
         .target_loads_off = "95 1512000:99",
         .scaling_min_freq = 1512000,
         .scaling_max_freq = 1512000,
+        .hotplug = {
+            .always_up = 1,
+            .up_load = 70,
+            .up_runqueue = 20,
+            .up_ms = 100,
+            .down_load = 35,
+            .down_runqueue = 15,
+            .down_ms = 500,
+            .boost_ms = 1000,
+            .backoff_ms = 10000,
+        },
     },
     [PROFILE_BIAS_POWER_SAVE] = {
         .boost = 0,
@@ -118,5 +161,76 @@ static power_profile profiles[PROFILE_MAX] = {
         .target_loads_off = "95 1512000:99",
         .scaling_min_freq = 384000,
         .scaling_max_freq = 1026000,
+        .hotplug = {
+            .up_load = 80,
+            .up_runqueue = 25,
+            .up_ms = 150,
+            .down_load = 40,
+            .down_runqueue = 18,
+            .down_ms = 300,
+            .boost_ms = 750,
+            .backoff_ms = 10000,
+        },
+    },
+    [PROFILE_LOW_POWER] = {
+        .boost = 0,
+        .boostpulse_duration = 0,
+        .go_hispeed_load = 99,
+        .go_hispeed_load_off = 110,
+        .hispeed_freq = 810000,
+        .hispeed_freq_off = 810000,
+        .timer_rate = 40000,
+        .timer_rate_off = 50000,
+        .above_hispeed_delay = "39000",
+        .io_is_busy = 0,
+        .min_sample_time = 39000,
+        .max_freq_hysteresis = 0,
+        .target_loads = "90",
+        .target_loads_off = "95 1512000:99",
+        .scaling_min_freq = 384000,
+        .scaling_max_freq = 918000,
+        .hotplug = {
+            .up_load = 95,
+            .up_runqueue = 30,
+            .up_ms = 500,
+            .down_load = 60,
+            .down_runqueue = 25,
+            .down_ms = 100,
+            .boost_ms = 0,
+            .backoff_ms = 10000,
+        },
+    },
+    /*
+     * scaling_max_freq is the highest frequency the plateau search may
+     * probe; it starts from hispeed_freq, see plateau.h.
+     */
+    [PROFILE_SUSTAINED_PERFORMANCE] = {
+        .boost = 0,
+        .boostpulse_duration = 0,
+        .go_hispeed_load = 90,
+        .go_hispeed_load_off = 110,
+        .hispeed_freq = 1134000,
+        .hispeed_freq_off = 1134000,
+        .timer_rate = 20000,
+        .timer_rate_off = 50000,
+        .above_hispeed_delay = "19000",
+        .io_is_busy = 1,
+        .min_sample_time = 79000,
+        .max_freq_hysteresis = 99000,
+        .target_loads = "80",
+        .target_loads_off = "95 1512000:99",
+        .scaling_min_freq = 594000,
+        .scaling_max_freq = 1512000,
+        .hotplug = {
+            .always_up = 1,
+            .up_load = 70,
+            .up_runqueue = 20,
+            .up_ms = 100,
+            .down_load = 35,
+            .down_runqueue = 15,
+            .down_ms = 500,
+            .boost_ms = 0,
+            .backoff_ms = 10000,
+        },
     },
 };
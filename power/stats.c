@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define LOG_TAG "PowerHAL"
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include <latency_histogram.h>
+
+#include "clock.h"
+#include "stats.h"
+
+/*
+ * Latencies are kept in the log2 buckets of latency_histogram.h, whose sum
+ * is the sample count. Everything is updated with relaxed atomics from
+ * whichever thread made the call.
+ */
+struct hint_stats {
+    atomic_ullong total_ns;
+    atomic_ullong syscalls;
+    atomic_ulong buckets[LATENCY_BUCKETS];
+};
+
+struct lock_stats {
+    atomic_ulong acquired;
+    atomic_ulong contended;
+    atomic_ullong wait_ns;
+    atomic_ullong held_ns;
+    /* Only touched by the current holder */
+    int64_t held_since_ns;
+};
+
+/* Commits of queued profile and screen state, made under the HAL lock */
+struct commit_stats {
+    atomic_ulong count;
+    atomic_uint depth_max;
+    atomic_ullong latency_ns;
+    atomic_ullong latency_max_ns;
+};
+
+static const char *hint_names[STATS_HINT_MAX] = {
+    [STATS_HINT_INTERACTION] = "interaction",
+    [STATS_HINT_LAUNCH] = "launch",
+    [STATS_HINT_CPU_BOOST] = "cpu_boost",
+    [STATS_HINT_SET_PROFILE] = "set_profile",
+    [STATS_HINT_VIDEO_ENCODE] = "video_encode",
+    [STATS_HINT_LOW_POWER] = "low_power",
+    [STATS_HINT_SUSTAINED_PERFORMANCE] = "sustained_performance",
+    [STATS_SET_INTERACTIVE] = "set_interactive",
+};
+
+static const char *lock_names[STATS_LOCK_MAX] = {
+    [STATS_LOCK_HAL] = "hal",
+    [STATS_LOCK_REQUEST] = "request",
+};
+
+static const char *counter_names[STATS_COUNTER_MAX] = {
+    [STATS_BOOSTPULSE_WRITES] = "boostpulse.writes",
+    [STATS_BOOSTPULSE_COALESCED] = "boostpulse.coalesced",
+    [STATS_BOOSTPULSE_FAILURES] = "boostpulse.failures",
+    [STATS_BOOSTPULSE_REOPENS] = "boostpulse.reopens",
+    [STATS_INPUT_BOOSTS] = "input.boosts",
+    [STATS_BOOST_WINDOWS] = "boost.windows",
+    [STATS_BOOST_WINDOWS_MERGED] = "boost.windows_merged",
+    [STATS_CAMERA_BOOSTS] = "camera.boosts",
+    [STATS_CAMERA_RECORDINGS] = "camera.recordings",
+    [STATS_PROFILE_SWITCHES] = "profile.switches",
+    [STATS_GOVERNOR_RESTORES] = "governor.restores",
+    [STATS_PLATEAU_THROTTLES] = "plateau.throttles",
+    [STATS_PLATEAU_PROBES] = "plateau.probes",
+    [STATS_HOTPLUG_UP] = "hotplug.up",
+    [STATS_HOTPLUG_DOWN] = "hotplug.down",
+    [STATS_HOTPLUG_BOOSTS] = "hotplug.boosts",
+    [STATS_HOTPLUG_BACKOFFS] = "hotplug.backoffs",
+    [STATS_HOTPLUG_FALLBACKS] = "hotplug.fallbacks",
+    [STATS_SYSFS_SYSCALLS] = "sysfs.syscalls",
+    [STATS_SYSFS_SYSCALLS_SAVED] = "sysfs.syscalls_saved",
+    [STATS_SYSFS_WRITES_SKIPPED] = "sysfs.writes_skipped",
+    [STATS_SYSFS_REOPENS] = "sysfs.reopens",
+};
+
+static struct hint_stats hints[STATS_HINT_MAX];
+static struct lock_stats locks[STATS_LOCK_MAX];
+static struct commit_stats commits;
+static atomic_ulong counters[STATS_COUNTER_MAX];
+
+#define stats_add(counter, value) \
+    atomic_fetch_add_explicit(counter, value, memory_order_relaxed)
+#define stats_get(counter) \
+    atomic_load_explicit(counter, memory_order_relaxed)
+
+void stats_hint(int type, int64_t latency_ns, unsigned int syscalls)
+{
+    struct hint_stats *s = &hints[type];
+
+    if (latency_ns < 0)
+        latency_ns = 0;
+
+    stats_add(&s->total_ns, latency_ns);
+    stats_add(&s->syscalls, syscalls);
+    stats_add(&s->buckets[latency_bucket(latency_ns)], 1);
+}
+
+void stats_count(int counter, unsigned long value)
+{
+    stats_add(&counters[counter], value);
+}
+
+unsigned long stats_counter(int counter)
+{
+    return stats_get(&counters[counter]);
+}
+
+void stats_commit(unsigned int depth, int64_t latency_ns)
+{
+    /* Commits are serialized by the HAL lock, so there is a single writer */
+    stats_add(&commits.count, 1);
+    stats_add(&commits.latency_ns, latency_ns);
+    if (depth > stats_get(&commits.depth_max))
+        atomic_store_explicit(&commits.depth_max, depth, memory_order_relaxed);
+    if ((unsigned long long)latency_ns > stats_get(&commits.latency_max_ns))
+        atomic_store_explicit(&commits.latency_max_ns, latency_ns,
+                              memory_order_relaxed);
+}
+
+/*
+ * Lock the mutex, accounting for the time spent waiting when it was
+ * already held by someone else. Must be paired with stats_unlock().
+ */
+void stats_lock(pthread_mutex_t *mutex, int type)
+{
+    struct lock_stats *s = &locks[type];
+    int64_t start;
+
+    stats_add(&s->acquired, 1);
+
+    if (pthread_mutex_trylock(mutex)) {
+        start = now_ns();
+        pthread_mutex_lock(mutex);
+
+        s->held_since_ns = now_ns();
+        stats_add(&s->contended, 1);
+        stats_add(&s->wait_ns, s->held_since_ns - start);
+        return;
+    }
+
+    s->held_since_ns = now_ns();
+}
+
+void stats_unlock(pthread_mutex_t *mutex, int type)
+{
+    struct lock_stats *s = &locks[type];
+
+    stats_add(&s->held_ns, now_ns() - s->held_since_ns);
+    pthread_mutex_unlock(mutex);
+}
+
+/*
+ * Writes one key=value pair per line so that the output can be diffed
+ * between builds and parsed without any knowledge of the HAL.
+ */
+void stats_dump(int fd)
+{
+    unsigned long buckets[LATENCY_BUCKETS];
+    unsigned long count;
+    unsigned long long total, syscalls;
+    int i, b;
+
+    for (i = 0; i < STATS_COUNTER_MAX; i++)
+        dprintf(fd, "%s=%lu\n", counter_names[i], stats_get(&counters[i]));
+
+    count = stats_get(&commits.count);
+    dprintf(fd, "commit.count=%lu\n", count);
+    if (count) {
+        dprintf(fd, "commit.mean_latency_ns=%llu\n",
+                stats_get(&commits.latency_ns) / count);
+        dprintf(fd, "commit.max_latency_ns=%llu\n",
+                stats_get(&commits.latency_max_ns));
+        dprintf(fd, "commit.max_depth=%u\n", stats_get(&commits.depth_max));
+    }
+
+    for (i = 0; i < STATS_HINT_MAX; i++) {
+        count = 0;
+        for (b = 0; b < LATENCY_BUCKETS; b++) {
+            buckets[b] = stats_get(&hints[i].buckets[b]);
+            count += buckets[b];
+        }
+        total = stats_get(&hints[i].total_ns);
+        syscalls = stats_get(&hints[i].syscalls);
+
+        dprintf(fd, "hint.%s.count=%lu\n", hint_names[i], count);
+        if (!count)
+            continue;
+
+        dprintf(fd, "hint.%s.total_ns=%llu\n", hint_names[i], total);
+        dprintf(fd, "hint.%s.mean_ns=%llu\n", hint_names[i], total / count);
+        dprintf(fd, "hint.%s.p50_ns=%llu\n", hint_names[i],
+                latency_percentile_ns(buckets, count, 500));
+        dprintf(fd, "hint.%s.p99_ns=%llu\n", hint_names[i],
+                latency_percentile_ns(buckets, count, 990));
+        dprintf(fd, "hint.%s.p999_ns=%llu\n", hint_names[i],
+                latency_percentile_ns(buckets, count, 999));
+        dprintf(fd, "hint.%s.syscalls_per_call=%llu.%02llu\n", hint_names[i],
+                syscalls / count, syscalls * 100 / count % 100);
+    }
+
+    for (i = 0; i < STATS_LOCK_MAX; i++) {
+        dprintf(fd, "lock.%s.acquired=%lu\n", lock_names[i],
+                stats_get(&locks[i].acquired));
+        dprintf(fd, "lock.%s.contended=%lu\n", lock_names[i],
+                stats_get(&locks[i].contended));
+        dprintf(fd, "lock.%s.wait_ns=%llu\n", lock_names[i],
+                stats_get(&locks[i].wait_ns));
+        dprintf(fd, "lock.%s.held_ns=%llu\n", lock_names[i],
+                stats_get(&locks[i].held_ns));
+    }
+}
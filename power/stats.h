@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef POWER_STATS_H
+#define POWER_STATS_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+/* Entry points whose latency is tracked */
+enum {
+    STATS_HINT_INTERACTION = 0,
+    STATS_HINT_LAUNCH,
+    STATS_HINT_CPU_BOOST,
+    STATS_HINT_SET_PROFILE,
+    STATS_HINT_VIDEO_ENCODE,
+    STATS_HINT_LOW_POWER,
+    STATS_HINT_SUSTAINED_PERFORMANCE,
+    STATS_SET_INTERACTIVE,
+    STATS_HINT_MAX
+};
+
+/* Mutexes whose contention is tracked */
+enum {
+    STATS_LOCK_HAL = 0,
+    STATS_LOCK_REQUEST,
+    STATS_LOCK_MAX
+};
+
+/* Event counters */
+enum {
+    STATS_BOOSTPULSE_WRITES = 0,
+    STATS_BOOSTPULSE_COALESCED,
+    STATS_BOOSTPULSE_FAILURES,
+    STATS_BOOSTPULSE_REOPENS,
+    STATS_INPUT_BOOSTS,
+    STATS_BOOST_WINDOWS,
+    STATS_BOOST_WINDOWS_MERGED,
+    STATS_CAMERA_BOOSTS,
+    STATS_CAMERA_RECORDINGS,
+    STATS_PROFILE_SWITCHES,
+    STATS_GOVERNOR_RESTORES,
+    STATS_PLATEAU_THROTTLES,
+    STATS_PLATEAU_PROBES,
+    STATS_HOTPLUG_UP,
+    STATS_HOTPLUG_DOWN,
+    STATS_HOTPLUG_BOOSTS,
+    STATS_HOTPLUG_BACKOFFS,
+    STATS_HOTPLUG_FALLBACKS,
+    STATS_SYSFS_SYSCALLS,
+    STATS_SYSFS_SYSCALLS_SAVED,
+    STATS_SYSFS_WRITES_SKIPPED,
+    STATS_SYSFS_REOPENS,
+    STATS_COUNTER_MAX
+};
+
+void stats_hint(int type, int64_t latency_ns, unsigned int syscalls);
+void stats_count(int counter, unsigned long value);
+unsigned long stats_counter(int counter);
+void stats_commit(unsigned int depth, int64_t latency_ns);
+void stats_lock(pthread_mutex_t *mutex, int type);
+void stats_unlock(pthread_mutex_t *mutex, int type);
+void stats_dump(int fd);
+
+#endif // POWER_STATS_H
@@ -0,0 +1,57 @@
+#
+# Copyright (C) 2026 The LineageOS Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# The HAL is built into each host binary and pointed at a fake sysfs tree
+# through POWER_SYSFS_ROOT, see fake_sysfs.h.
+ifeq ($(HOST_OS),linux)
+
+LOCAL_PATH:= $(call my-dir)
+
+power_hal_src_files := \
+    ../power.c ../hotplug.c ../input_boost.c ../plateau.c ../stats.c
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := $(power_hal_src_files) fake_sysfs.c power_test.cpp \
+    plateau_test.cpp
+LOCAL_CFLAGS := -D_GNU_SOURCE
+# Leaks of replaced profile strings fail the run
+LOCAL_SANITIZE := address
+LOCAL_STATIC_LIBRARIES := libcutils liblog
+LOCAL_LDLIBS := -lpthread -lrt
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := power.msm8960_test
+include $(BUILD_HOST_NATIVE_TEST)
+
+# The hotplug thread on its own, fed a fake /proc/stat
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := ../hotplug.c ../stats.c fake_sysfs.c hotplug_test.cpp
+LOCAL_CFLAGS := -D_GNU_SOURCE
+LOCAL_STATIC_LIBRARIES := libcutils liblog
+LOCAL_LDLIBS := -lpthread -lrt
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := power.msm8960_hotplug_test
+include $(BUILD_HOST_NATIVE_TEST)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := $(power_hal_src_files) fake_sysfs.c power_benchmark.c
+LOCAL_CFLAGS := -D_GNU_SOURCE
+LOCAL_STATIC_LIBRARIES := libcutils liblog
+LOCAL_LDLIBS := -lpthread -lrt
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := power.msm8960_benchmark
+include $(BUILD_HOST_EXECUTABLE)
+
+endif
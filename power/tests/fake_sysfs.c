@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fake_sysfs.h"
+
+#define CPU_DIR "sys/devices/system/cpu"
+#define SCALING_GOVERNOR CPU_DIR "/cpu0/cpufreq/scaling_governor"
+
+struct fake_node {
+    const char *path;
+    const char *value;
+};
+
+static const char *const dirs[] = {
+    FAKE_INTERACTIVE_DIR,
+    FAKE_CPUFREQ_LIMIT_DIR,
+    CPU_DIR "/cpu0/cpufreq",
+    CPU_DIR "/cpu1",
+    "proc",
+};
+
+static const char *const tunables[] = {
+    FAKE_INTERACTIVE_DIR "/boost",
+    FAKE_INTERACTIVE_DIR "/boostpulse",
+    FAKE_INTERACTIVE_DIR "/boostpulse_duration",
+    FAKE_INTERACTIVE_DIR "/go_hispeed_load",
+    FAKE_INTERACTIVE_DIR "/hispeed_freq",
+    FAKE_INTERACTIVE_DIR "/above_hispeed_delay",
+    FAKE_INTERACTIVE_DIR "/timer_rate",
+    FAKE_INTERACTIVE_DIR "/io_is_busy",
+    FAKE_INTERACTIVE_DIR "/min_sample_time",
+    FAKE_INTERACTIVE_DIR "/max_freq_hysteresis",
+    FAKE_INTERACTIVE_DIR "/target_loads",
+    FAKE_CPUFREQ_LIMIT_DIR "/scaling_min_freq",
+    FAKE_CPUFREQ_LIMIT_DIR "/scaling_max_freq",
+};
+
+/* Read-only nodes, with what an msm8960 reports */
+static const struct fake_node status_nodes[] = {
+    { SCALING_GOVERNOR, "interactive\n" },
+    { CPU_DIR "/cpu0/cpufreq/scaling_max_freq", "1512000\n" },
+    { CPU_DIR "/cpu0/cpufreq/scaling_available_frequencies",
+      "384000 486000 594000 702000 810000 918000 1026000 1134000 1242000 "
+      "1350000 1458000 1512000 \n" },
+    { FAKE_CPU1_ONLINE, "1\n" },
+    { FAKE_PROC_STAT,
+      "cpu  4705 356 584 3699 23 23 0 0 0 0\n"
+      "cpu0 2353 178 292 1849 11 11 0 0 0 0\n"
+      "cpu1 2352 178 292 1850 12 12 0 0 0 0\n"
+      "intr 114930548 113199788 3 0 5 263 0 4\n"
+      "ctxt 1990473\n"
+      "btime 1062191376\n"
+      "processes 2915\n"
+      "procs_running 1\n"
+      "procs_blocked 0\n" },
+};
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+static int write_node(const char *root, const char *node, const char *value)
+{
+    char path[PATH_MAX];
+    size_t len = strlen(value);
+    int fd, ret = 0;
+
+    snprintf(path, sizeof(path), "%s/%s", root, node);
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return -1;
+
+    if (len && write(fd, value, len) != (ssize_t)len)
+        ret = -1;
+
+    close(fd);
+    return ret;
+}
+
+static int make_dirs(const char *root, const char *dir)
+{
+    char path[PATH_MAX];
+    char *p;
+
+    snprintf(path, sizeof(path), "%s/%s", root, dir);
+    for (p = path + strlen(root) + 1; (p = strchr(p, '/')); p++) {
+        *p = '\0';
+        if (mkdir(path, 0755) && errno != EEXIST)
+            return -1;
+        *p = '/';
+    }
+
+    return mkdir(path, 0755) && errno != EEXIST ? -1 : 0;
+}
+
+int fake_sysfs_create(char *root, size_t size)
+{
+    const char *tmp = getenv("TMPDIR");
+    size_t i;
+
+    snprintf(root, size, "%s/power_sysfs.XXXXXX", tmp ? tmp : "/tmp");
+    if (!mkdtemp(root))
+        return -1;
+
+    for (i = 0; i < ARRAY_SIZE(dirs); i++) {
+        if (make_dirs(root, dirs[i]))
+            goto fail;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(tunables); i++) {
+        if (write_node(root, tunables[i], ""))
+            goto fail;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(status_nodes); i++) {
+        if (write_node(root, status_nodes[i].path, status_nodes[i].value))
+            goto fail;
+    }
+
+    setenv("POWER_SYSFS_ROOT", root, 1);
+    setenv("POWER_PROCFS_ROOT", root, 1);
+    return 0;
+
+fail:
+    fake_sysfs_remove(root);
+    return -1;
+}
+
+void fake_sysfs_clear(const char *root)
+{
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(tunables); i++)
+        write_node(root, tunables[i], "");
+}
+
+static int remove_entry(const char *path,
+                        __attribute__((unused)) const struct stat *s,
+                        __attribute__((unused)) int flag,
+                        __attribute__((unused)) struct FTW *ftw)
+{
+    return remove(path);
+}
+
+/* Build the interactive directory aside and move it into place */
+static int create_interactive_dir(const char *root)
+{
+    static const char new_dir[] = FAKE_INTERACTIVE_DIR ".new";
+    char node[PATH_MAX], from[PATH_MAX], to[PATH_MAX];
+    size_t i, len = strlen(FAKE_INTERACTIVE_DIR);
+
+    if (make_dirs(root, new_dir))
+        return -1;
+
+    for (i = 0; i < ARRAY_SIZE(tunables); i++) {
+        if (strncmp(tunables[i], FAKE_INTERACTIVE_DIR "/", len + 1))
+            continue;
+
+        snprintf(node, sizeof(node), "%s%s", new_dir, tunables[i] + len);
+        if (write_node(root, node, ""))
+            return -1;
+    }
+
+    snprintf(from, sizeof(from), "%s/%s", root, new_dir);
+    snprintf(to, sizeof(to), "%s/%s", root, FAKE_INTERACTIVE_DIR);
+    return rename(from, to);
+}
+
+int fake_sysfs_set_governor(const char *root, const char *governor)
+{
+    char dir[PATH_MAX], value[32];
+    struct stat s;
+    bool exists;
+
+    snprintf(dir, sizeof(dir), "%s/%s", root, FAKE_INTERACTIVE_DIR);
+    exists = stat(dir, &s) == 0;
+
+    if (!strcmp(governor, "interactive")) {
+        if (!exists && create_interactive_dir(root))
+            return -1;
+    } else if (exists) {
+        if (nftw(dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS))
+            return -1;
+    }
+
+    snprintf(value, sizeof(value), "%s\n", governor);
+    return write_node(root, SCALING_GOVERNOR, value);
+}
+
+int fake_sysfs_write(const char *root, const char *node, const char *value)
+{
+    return write_node(root, node, value);
+}
+
+int fake_sysfs_read(const char *root, const char *node, char *buf, size_t size)
+{
+    char path[PATH_MAX];
+    ssize_t len;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/%s", root, node);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    len = read(fd, buf, size - 1);
+    close(fd);
+    if (len < 0)
+        return -1;
+
+    buf[len] = '\0';
+    return len;
+}
+
+void fake_sysfs_remove(const char *root)
+{
+    nftw(root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
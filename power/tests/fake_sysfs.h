@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef POWER_FAKE_SYSFS_H
+#define POWER_FAKE_SYSFS_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Directories of the tunables, relative to the root */
+#define FAKE_INTERACTIVE_DIR "sys/devices/system/cpu/cpufreq/interactive"
+#define FAKE_CPUFREQ_LIMIT_DIR "sys/kernel/cpufreq_limit/cpufreq"
+
+/* What the hotplug thread reads, and cpu1's online node it writes */
+#define FAKE_PROC_STAT "proc/stat"
+#define FAKE_CPU1_ONLINE "sys/devices/system/cpu/cpu1/online"
+
+/*
+ * Create a tree in a new temporary directory holding every node the HAL
+ * opens, with the interactive governor selected, and point the HAL at it
+ * through POWER_SYSFS_ROOT and POWER_PROCFS_ROOT. The tree must be set up
+ * before the HAL's init() runs. Returns 0 and the root in root, or -1.
+ */
+int fake_sysfs_create(char *root, size_t size);
+
+/* Empty every tunable, so that only what the HAL writes next shows up */
+void fake_sysfs_clear(const char *root);
+
+/*
+ * Switch cpu0 to governor the way the kernel does: the interactive
+ * directory goes away when another governor is picked, and a new one with
+ * empty tunables appears, in one go, when it is picked again. Returns 0 or
+ * -1.
+ */
+int fake_sysfs_set_governor(const char *root, const char *governor);
+
+/*
+ * Replace what node, a path relative to root, holds with value, as the
+ * kernel would; returns 0 or -1.
+ */
+int fake_sysfs_write(const char *root, const char *node, const char *value);
+
+/* Read node, a path relative to root, into buf; returns the length or -1 */
+int fake_sysfs_read(const char *root, const char *node, char *buf, size_t size);
+
+void fake_sysfs_remove(const char *root);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // POWER_FAKE_SYSFS_H
@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "fake_sysfs.h"
+
+extern "C" {
+#include "../hotplug.h"
+#include "../stats.h"
+}
+
+/* Like the balanced profile, with shorter holds to keep the tests short */
+static const struct hotplug_thresholds kThresholds = {
+    .always_up = 0,
+    .up_load = 70,
+    .up_runqueue = 20,
+    .up_ms = 100,
+    .down_load = 35,
+    .down_runqueue = 15,
+    .down_ms = 300,
+    .boost_ms = 500,
+    .backoff_ms = 200,
+};
+
+static int64_t NowMs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static void SleepMs(int ms)
+{
+    const struct timespec delay = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&delay, NULL);
+}
+
+/* Poll for done, for up to timeout_ms; returns whether it happened */
+static bool WaitFor(const std::function<bool()> &done, int timeout_ms)
+{
+    for (int i = 0; i < timeout_ms && !done(); i++)
+        SleepMs(1);
+
+    return done();
+}
+
+/*
+ * Nothing is started when the nodes can't be opened, mpdecision is asked
+ * for instead. Each case runs in a child of its own, as the thread can only
+ * be started once per process.
+ */
+TEST(HotplugFallbackDeathTest, FallsBackWithoutNodes)
+{
+    setenv("POWER_HOTPLUG", "1", 1);
+    EXPECT_EXIT({
+        hotplug_start("/nonexistent/stat", "/nonexistent/online",
+                &kThresholds);
+        exit(stats_counter(STATS_HOTPLUG_FALLBACKS) == 1 ? 0 : 1);
+    }, ::testing::ExitedWithCode(0), "");
+}
+
+TEST(HotplugFallbackDeathTest, NoFallbackWhenDisabled)
+{
+    setenv("POWER_HOTPLUG", "0", 1);
+    EXPECT_EXIT({
+        hotplug_start("/nonexistent/stat", "/nonexistent/online",
+                &kThresholds);
+        exit(stats_counter(STATS_HOTPLUG_FALLBACKS) == 0 ? 0 : 1);
+    }, ::testing::ExitedWithCode(0), "");
+}
+
+/*
+ * The hotplug thread is started once, against a fake tree, for the whole
+ * suite. A feeder thread stands in for the kernel, advancing the cpu line
+ * of the fake /proc/stat by the load each test picks, so that any two
+ * samples see exactly that load.
+ */
+class HotplugTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+        ASSERT_EQ(0, fake_sysfs_create(root, sizeof(root)));
+
+        SetLoad(0, 1);
+        Feed();
+        feeding = true;
+        feeder = std::thread([] {
+            while (feeding) {
+                Feed();
+                SleepMs(5);
+            }
+        });
+
+        std::string stat = std::string(root) + "/" + FAKE_PROC_STAT;
+        std::string online = std::string(root) + "/" + FAKE_CPU1_ONLINE;
+        setenv("POWER_HOTPLUG", "1", 1);
+        hotplug_start(stat.c_str(), online.c_str(), &kThresholds);
+        ASSERT_EQ(0UL, stats_counter(STATS_HOTPLUG_FALLBACKS));
+    }
+
+    static void TearDownTestCase()
+    {
+        feeding = false;
+        feeder.join();
+        fake_sysfs_remove(root);
+    }
+
+    void SetUp() override
+    {
+        SetThresholds(kThresholds);
+    }
+
+    static void SetThresholds(const struct hotplug_thresholds &t)
+    {
+        hotplug_set_state(&t, true);
+    }
+
+    /* Busy percentage of the CPUs, and tasks running including the reader */
+    static void SetLoad(int load, int running)
+    {
+        std::lock_guard<std::mutex> lock(feed_lock);
+        feed_load = load;
+        feed_running = running;
+    }
+
+    static void SetIdle() { SetLoad(5, 1); }
+    static void SetBusy() { SetLoad(90, 5); }
+
+    static bool Online()
+    {
+        char value[8];
+
+        return fake_sysfs_read(root, FAKE_CPU1_ONLINE, value,
+                sizeof(value)) > 0 && value[0] == '1';
+    }
+
+    /* Take cpu1 down from outside the HAL, as msm_thermal would */
+    static void TakeDown()
+    {
+        ASSERT_EQ(0, fake_sysfs_write(root, FAKE_CPU1_ONLINE, "0\n"));
+    }
+
+    /* Wait for cpu1 to be online, or not; returns how long that took */
+    static int64_t WaitForOnline(bool online, int timeout_ms = 2000)
+    {
+        int64_t start = NowMs();
+
+        EXPECT_TRUE(WaitFor([=] { return Online() == online; }, timeout_ms))
+                << "cpu1 never went " << (online ? "up" : "down");
+        return NowMs() - start;
+    }
+
+    /* Whether cpu1 stays online, or not, for ms */
+    static bool StaysOnline(bool online, int ms)
+    {
+        return !WaitFor([=] { return Online() != online; }, ms);
+    }
+
+    static void BringUp()
+    {
+        SetBusy();
+        WaitForOnline(true);
+    }
+
+    static void BringDown()
+    {
+        SetIdle();
+        WaitForOnline(false);
+    }
+
+private:
+    /* Counters are fixed width, so each write is the same length */
+    static void Feed()
+    {
+        char stat[160];
+
+        {
+            std::lock_guard<std::mutex> lock(feed_lock);
+            busy += feed_load;
+            idle += 100 - feed_load;
+            snprintf(stat, sizeof(stat),
+                    "cpu  %012llu 0 0 %012llu 0 0 0 0 0 0\n"
+                    "procs_running %03d\n"
+                    "procs_blocked 000\n",
+                    busy, idle, feed_running);
+        }
+
+        fake_sysfs_write(root, FAKE_PROC_STAT, stat);
+    }
+
+    static char root[PATH_MAX];
+    static std::thread feeder;
+    static std::atomic<bool> feeding;
+    static std::mutex feed_lock;
+    static int feed_load;
+    static int feed_running;
+    static unsigned long long busy;
+    static unsigned long long idle;
+};
+
+char HotplugTest::root[PATH_MAX];
+std::thread HotplugTest::feeder;
+std::atomic<bool> HotplugTest::feeding(false);
+std::mutex HotplugTest::feed_lock;
+int HotplugTest::feed_load;
+int HotplugTest::feed_running;
+unsigned long long HotplugTest::busy;
+unsigned long long HotplugTest::idle;
+
+TEST_F(HotplugTest, UpUnderLoad)
+{
+    BringDown();
+    unsigned long ups = stats_counter(STATS_HOTPLUG_UP);
+
+    SetBusy();
+    EXPECT_LE(kThresholds.up_ms, WaitForOnline(true));
+    EXPECT_EQ(ups + 1, stats_counter(STATS_HOTPLUG_UP));
+}
+
+/* Busy CPUs alone don't bring it up, tasks have to queue up as well */
+TEST_F(HotplugTest, UpNeedsRunQueue)
+{
+    BringDown();
+
+    SetLoad(90, 1);
+    EXPECT_TRUE(StaysOnline(false, 1000));
+}
+
+TEST_F(HotplugTest, DownWhenIdle)
+{
+    BringUp();
+    unsigned long downs = stats_counter(STATS_HOTPLUG_DOWN);
+
+    SetIdle();
+    EXPECT_LE(kThresholds.down_ms, WaitForOnline(false));
+    EXPECT_EQ(downs + 1, stats_counter(STATS_HOTPLUG_DOWN));
+}
+
+/* Between the up and down thresholds, cpu1 stays as it is */
+TEST_F(HotplugTest, HoldsBetweenThresholds)
+{
+    BringUp();
+    SetLoad(50, 3);
+    EXPECT_TRUE(StaysOnline(true, 1000));
+
+    BringDown();
+    SetLoad(50, 3);
+    EXPECT_TRUE(StaysOnline(false, 1000));
+}
+
+TEST_F(HotplugTest, AlwaysUpIgnoresLoad)
+{
+    struct hotplug_thresholds t = kThresholds;
+
+    BringDown();
+    t.always_up = 1;
+    SetThresholds(t);
+    WaitForOnline(true);
+    EXPECT_TRUE(StaysOnline(true, 1000));
+}
+
+/* A boost brings it up while idle, and holds it up for boost_ms */
+TEST_F(HotplugTest, BoostHoldsUp)
+{
+    unsigned long boosts = stats_counter(STATS_HOTPLUG_BOOSTS);
+
+    BringDown();
+    int64_t start = NowMs();
+    hotplug_boost();
+    WaitForOnline(true);
+    EXPECT_EQ(boosts + 1, stats_counter(STATS_HOTPLUG_BOOSTS));
+
+    WaitForOnline(false);
+    EXPECT_LE(kThresholds.boost_ms + kThresholds.down_ms, NowMs() - start);
+}
+
+/*
+ * Once cpu1 is taken down behind the HAL's back, neither always_up nor a
+ * boost bring it back until the back-off is over.
+ */
+TEST_F(HotplugTest, ThermalOfflineIsRespected)
+{
+    struct hotplug_thresholds t = kThresholds;
+    unsigned long backoffs = stats_counter(STATS_HOTPLUG_BACKOFFS);
+
+    t.always_up = 1;
+    SetThresholds(t);
+    WaitForOnline(true);
+
+    int64_t start = NowMs();
+    TakeDown();
+    EXPECT_TRUE(StaysOnline(false, kThresholds.backoff_ms / 2));
+    hotplug_boost();
+    EXPECT_TRUE(StaysOnline(false, kThresholds.backoff_ms / 4));
+    EXPECT_EQ(backoffs + 1, stats_counter(STATS_HOTPLUG_BACKOFFS));
+
+    WaitForOnline(true);
+    EXPECT_LE(kThresholds.backoff_ms, NowMs() - start);
+    EXPECT_EQ(backoffs + 1, stats_counter(STATS_HOTPLUG_BACKOFFS));
+}
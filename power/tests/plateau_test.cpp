@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "../plateau.h"
+}
+
+static const int64_t kSec = 1000000000LL;
+
+/* What an msm8960 reports, and the ceiling of the sustained profile */
+static const char kAvailableFreqs[] =
+    "384000 486000 594000 702000 810000 918000 1026000 1134000 1242000 "
+    "1350000 1458000 1512000 \n";
+static const int kMaxFreq = 1512000;
+
+/* The search is pure, time is whatever each test feeds it */
+class PlateauTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        memset(&p, 0, sizeof(p));
+        ASSERT_EQ(12, plateau_set_freqs(&p, kAvailableFreqs));
+        plateau_start(&p, 1134000, kMaxFreq, 0);
+    }
+
+    struct plateau p;
+};
+
+TEST(PlateauFreqsTest, OnlyAscendingFrequenciesAreKept)
+{
+    struct plateau p;
+
+    EXPECT_EQ(3, plateau_set_freqs(&p, "384000 486000 486000 100 -5 594000"));
+    EXPECT_EQ(384000, p.freqs[0]);
+    EXPECT_EQ(486000, p.freqs[1]);
+    EXPECT_EQ(594000, p.freqs[2]);
+}
+
+TEST(PlateauFreqsTest, WithoutTableStartFreqIsHeld)
+{
+    struct plateau p;
+
+    EXPECT_EQ(0, plateau_set_freqs(&p, ""));
+    plateau_start(&p, 1134000, kMaxFreq, 0);
+    EXPECT_EQ(1134000, plateau_freq(&p));
+    EXPECT_EQ(PLATEAU_HELD, plateau_sample(&p, kMaxFreq, 3600 * kSec));
+    EXPECT_EQ(1134000, plateau_freq(&p));
+}
+
+TEST_F(PlateauTest, StartsWithinTable)
+{
+    EXPECT_EQ(1134000, plateau_freq(&p));
+
+    /* Between two steps, the one below */
+    plateau_start(&p, 1200000, kMaxFreq, 0);
+    EXPECT_EQ(1134000, plateau_freq(&p));
+
+    /* Never above the ceiling */
+    plateau_start(&p, kMaxFreq, 1026000, 0);
+    EXPECT_EQ(1026000, plateau_freq(&p));
+}
+
+TEST_F(PlateauTest, HeldWhileAllowed)
+{
+    EXPECT_EQ(PLATEAU_HELD, plateau_sample(&p, kMaxFreq, 1 * kSec));
+    EXPECT_EQ(PLATEAU_HELD, plateau_sample(&p, 1134000, 2 * kSec));
+    /* An unreadable policy limit is no limit */
+    EXPECT_EQ(PLATEAU_HELD, plateau_sample(&p, -1, 3 * kSec));
+    EXPECT_EQ(1134000, plateau_freq(&p));
+}
+
+TEST_F(PlateauTest, BacksOffBelowPolicyMax)
+{
+    /* A step below a limit that is in the table */
+    EXPECT_EQ(PLATEAU_BACKED_OFF, plateau_sample(&p, 1026000, 1 * kSec));
+    EXPECT_EQ(918000, plateau_freq(&p));
+
+    /* The highest step under one that isn't */
+    plateau_start(&p, 1134000, kMaxFreq, 0);
+    EXPECT_EQ(PLATEAU_BACKED_OFF, plateau_sample(&p, 1000000, 1 * kSec));
+    EXPECT_EQ(918000, plateau_freq(&p));
+
+    /* Never below the lowest */
+    EXPECT_EQ(PLATEAU_BACKED_OFF, plateau_sample(&p, 300000, 2 * kSec));
+    EXPECT_EQ(384000, plateau_freq(&p));
+}
+
+TEST_F(PlateauTest, ProbesAfterQuietPeriod)
+{
+    EXPECT_EQ(PLATEAU_HELD, plateau_sample(&p, kMaxFreq, 60 * kSec - 1));
+    EXPECT_EQ(PLATEAU_PROBED, plateau_sample(&p, kMaxFreq, 60 * kSec));
+    EXPECT_EQ(1242000, plateau_freq(&p));
+
+    /* The quiet period starts over from the probe */
+    EXPECT_EQ(PLATEAU_HELD, plateau_sample(&p, kMaxFreq, 120 * kSec - 1));
+    EXPECT_EQ(PLATEAU_PROBED, plateau_sample(&p, kMaxFreq, 120 * kSec));
+    EXPECT_EQ(1350000, plateau_freq(&p));
+}
+
+TEST_F(PlateauTest, ProbeIntervalDoublesPerThrottle)
+{
+    int64_t now = 0;
+
+    for (int throttles = 1; throttles <= 6; throttles++) {
+        /* Throttled just under the step probed last, then quiet again */
+        EXPECT_EQ(PLATEAU_BACKED_OFF,
+                plateau_sample(&p, plateau_freq(&p) - 1, now));
+        int64_t wait = (60 * kSec) << (throttles < 4 ? throttles : 4);
+
+        EXPECT_EQ(PLATEAU_HELD, plateau_sample(&p, kMaxFreq, now + wait - 1))
+                << throttles << " throttles";
+        EXPECT_EQ(PLATEAU_PROBED, plateau_sample(&p, kMaxFreq, now + wait))
+                << throttles << " throttles";
+        now += wait;
+    }
+}
+
+TEST_F(PlateauTest, NeverProbesAboveCeiling)
+{
+    plateau_start(&p, kMaxFreq, kMaxFreq, 0);
+    EXPECT_EQ(PLATEAU_HELD, plateau_sample(&p, kMaxFreq, 3600 * kSec));
+    EXPECT_EQ(kMaxFreq, plateau_freq(&p));
+}
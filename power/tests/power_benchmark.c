@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <hardware/power.h>
+
+#include "../stats.h"
+#include "fake_sysfs.h"
+
+/*
+ * Drives every hint the HAL handles against a fake tree from a number of
+ * threads, as binder threads would, and prints the HAL statistics along
+ * with the totals of the run as key=value lines on stdout, so that runs of
+ * different builds can be diffed.
+ *
+ *   power.msm8960_benchmark [-t threads] [-n iterations per thread]
+ */
+#define DEFAULT_THREADS 1
+#define DEFAULT_ITERATIONS 10000
+#define MAX_THREADS 64
+
+#define NSEC_PER_SEC 1000000000LL
+
+extern struct power_module HAL_MODULE_INFO_SYM;
+
+struct bench_thread {
+    pthread_t thread;
+    int iterations;
+    unsigned long calls;
+};
+
+static pthread_barrier_t start_barrier;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/* Returns the number of calls made into the HAL */
+static unsigned long run_hints(struct power_module *module, int iterations)
+{
+    int32_t profile, duration, launch = 1;
+    unsigned long calls = 0;
+    int i;
+
+    for (i = 0; i < iterations; i++) {
+        module->powerHint(module, POWER_HINT_INTERACTION, NULL);
+
+        duration = 100;
+        module->powerHint(module, POWER_HINT_INTERACTION, &duration);
+
+        duration = 50000;
+        module->powerHint(module, POWER_HINT_CPU_BOOST, &duration);
+
+        calls += 3;
+        if (i % 100)
+            continue;
+
+        /* The rest, at a rate closer to that of a real device */
+        module->powerHint(module, POWER_HINT_LAUNCH, &launch);
+        module->powerHint(module, POWER_HINT_LAUNCH, NULL);
+
+        profile = i / 100 % 3;
+        module->powerHint(module, POWER_HINT_SET_PROFILE, &profile);
+        module->powerHint(module, POWER_HINT_VIDEO_ENCODE,
+                i / 100 % 2 ? "state=1" : "state=0");
+        module->setInteractive(module, i / 100 % 4 != 3);
+        calls += 5;
+    }
+
+    return calls;
+}
+
+static void *bench_thread(void *arg)
+{
+    struct bench_thread *t = arg;
+
+    pthread_barrier_wait(&start_barrier);
+    t->calls = run_hints(&HAL_MODULE_INFO_SYM, t->iterations);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    struct power_module *module = &HAL_MODULE_INFO_SYM;
+    struct bench_thread threads[MAX_THREADS];
+    int nthreads = DEFAULT_THREADS;
+    int iterations = DEFAULT_ITERATIONS;
+    unsigned long calls = 0;
+    char root[PATH_MAX];
+    int64_t start, wall_ns;
+    int i, opt;
+
+    while ((opt = getopt(argc, argv, "t:n:")) != -1) {
+        switch (opt) {
+        case 't':
+            nthreads = atoi(optarg);
+            break;
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        default:
+            nthreads = 0;
+            break;
+        }
+    }
+
+    if (nthreads < 1 || nthreads > MAX_THREADS || iterations < 1) {
+        fprintf(stderr, "usage: %s [-t threads, up to %d] [-n iterations]\n",
+                argv[0], MAX_THREADS);
+        return 1;
+    }
+
+    if (fake_sysfs_create(root, sizeof(root))) {
+        perror("fake_sysfs_create");
+        return 1;
+    }
+
+    module->init(module);
+
+    pthread_barrier_init(&start_barrier, NULL, nthreads + 1);
+    for (i = 0; i < nthreads; i++) {
+        threads[i].iterations = iterations;
+        if (pthread_create(&threads[i].thread, NULL, bench_thread,
+                &threads[i])) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+
+    pthread_barrier_wait(&start_barrier);
+    start = now_ns();
+    for (i = 0; i < nthreads; i++) {
+        pthread_join(threads[i].thread, NULL);
+        calls += threads[i].calls;
+    }
+    wall_ns = now_ns() - start;
+
+    printf("bench.threads=%d\n", nthreads);
+    printf("bench.iterations=%d\n", iterations);
+    printf("bench.calls=%lu\n", calls);
+    printf("bench.wall_ns=%lld\n", (long long)wall_ns);
+    printf("bench.calls_per_sec=%llu\n",
+           (unsigned long long)(calls * NSEC_PER_SEC / (wall_ns ? wall_ns : 1)));
+    fflush(stdout);
+    stats_dump(STDOUT_FILENO);
+
+    fake_sysfs_remove(root);
+    return 0;
+}
@@ -0,0 +1,849 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/input.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <hardware/power.h>
+
+#include "fake_sysfs.h"
+
+extern "C" {
+#include "../stats.h"
+}
+
+extern "C" struct power_module HAL_MODULE_INFO_SYM;
+
+/* A node written by the HAL, and what it holds afterwards */
+typedef std::pair<std::string, std::string> Write;
+typedef std::vector<Write> Writes;
+
+static const Writes kBalancedWrites = {
+    { "boost", "0" },
+    { "boostpulse_duration", "40000" },
+    { "go_hispeed_load", "90" },
+    { "hispeed_freq", "1134000" },
+    { "above_hispeed_delay", "19000 1400000:39000" },
+    { "timer_rate", "20000" },
+    { "io_is_busy", "1" },
+    { "min_sample_time", "39000" },
+    { "max_freq_hysteresis", "99000" },
+    { "target_loads", "85 1500000:90" },
+    { "scaling_min_freq", "384000" },
+    { "scaling_max_freq", "1512000" },
+};
+
+static const Writes kHighPerformanceTunables = {
+    { "boost", "1" },
+    { "boostpulse_duration", "40000" },
+    { "go_hispeed_load", "90" },
+    { "hispeed_freq", "1134000" },
+    { "above_hispeed_delay", "19000 1400000:39000" },
+    { "timer_rate", "20000" },
+    { "io_is_busy", "1" },
+    { "min_sample_time", "39000" },
+    { "max_freq_hysteresis", "99000" },
+    { "target_loads", "85 1500000:90" },
+    { "scaling_min_freq", "1512000" },
+    { "scaling_max_freq", "1512000" },
+};
+
+/*
+ * Loaded at init. Only bias_power_save is overridden, so that the other
+ * tests see the built-in profiles; every invalid line keeps the default.
+ */
+static const char kProfilesConfig[] =
+    "# Tuned for the test\n"
+    "[bias_power_save]\n"
+    "hispeed_freq = 918000\n"
+    "  above_hispeed_delay=29000  \n"
+    "timer_rate = 12abc\n"
+    "scaling_max_freq = -1\n"
+    "target_loads = 80 high\n"
+    "target_loads = 75\n"
+    "target_loads = 70 1026000:85\n"
+    "no_such_key = 1\n"
+    "not a setting\n"
+    "[no_such_profile]\n"
+    "hispeed_freq = 1\n";
+
+/* Caps boost windows instead of the real 5 s, to keep the tests short */
+static const int kBoostMaxMs = 1000;
+
+/*
+ * The HAL is initialized once, against a fake tree, for the whole suite.
+ * Each test starts from the balanced profile with the screen on and no
+ * video encoding and checks which nodes the HAL then writes, in order,
+ * through the IN_MODIFY events of the tree.
+ */
+class PowerHalTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+        ASSERT_EQ(0, fake_sysfs_create(root, sizeof(root)));
+
+        watch_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+        ASSERT_LE(0, watch_fd);
+        Watch(FAKE_INTERACTIVE_DIR);
+        Watch(FAKE_CPUFREQ_LIMIT_DIR);
+
+        std::string config = std::string(root) + "/power_profiles.conf";
+        FILE *f = fopen(config.c_str(), "w");
+        ASSERT_TRUE(f != NULL);
+        fputs(kProfilesConfig, f);
+        fclose(f);
+        setenv("POWER_PROFILES_CONFIG", config.c_str(), 1);
+        setenv("POWER_BOOST_MAX_MS", std::to_string(kBoostMaxMs).c_str(), 1);
+
+        /* Stands in for the touchscreen, see Touch() */
+        std::string touchscreen = std::string(root) + "/touchscreen";
+        ASSERT_EQ(0, mkfifo(touchscreen.c_str(), 0600));
+        setenv("POWER_INPUT_BOOST", "1", 1);
+        setenv("POWER_INPUT_BOOST_DEVICE", touchscreen.c_str(), 1);
+
+        module = &HAL_MODULE_INFO_SYM;
+        module->init(module);
+
+        /* Kept open, the HAL stops reading once the last writer is gone */
+        touch_fd = open(touchscreen.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+        ASSERT_LE(0, touch_fd);
+
+        SetProfile(PROFILE_BALANCED);
+        initial_writes = ReadWrites();
+    }
+
+    static void TearDownTestCase()
+    {
+        close(touch_fd);
+        close(watch_fd);
+        fake_sysfs_remove(root);
+    }
+
+    void SetUp() override
+    {
+        VideoEncode(false);
+        SetInteractive(true);
+        SetProfile(PROFILE_BALANCED);
+        ReadWrites();
+    }
+
+    enum {
+        PROFILE_POWER_SAVE = 0,
+        PROFILE_BALANCED,
+        PROFILE_HIGH_PERFORMANCE,
+        PROFILE_BIAS_POWER_SAVE,
+    };
+
+    static void SetProfile(int profile)
+    {
+        Commit([=] {
+            int data = profile;
+            module->powerHint(module, POWER_HINT_SET_PROFILE, &data);
+        });
+    }
+
+    static void SetInteractive(bool on)
+    {
+        Commit([=] { module->setInteractive(module, on); });
+    }
+
+    static void VideoEncode(bool on)
+    {
+        Commit([=] {
+            char data[16];
+            snprintf(data, sizeof(data), "state=%d", on);
+            module->powerHint(module, POWER_HINT_VIDEO_ENCODE, data);
+        });
+    }
+
+    /* Enter or leave a mode, as LOW_POWER and SUSTAINED_PERFORMANCE take */
+    static void SetMode(power_hint_t hint, const int32_t *data)
+    {
+        Commit([=] { module->powerHint(module, hint, (void *)data); });
+    }
+
+    /* An interaction lasting ms, or of no given length with 0 */
+    static void Interaction(int ms)
+    {
+        int data = ms;
+        module->powerHint(module, POWER_HINT_INTERACTION, ms ? &data : NULL);
+    }
+
+    /* A finger going down on the touchscreen and lifting, as type B reports */
+    static void Touch()
+    {
+        static const struct {
+            __u16 type;
+            __u16 code;
+            __s32 value;
+        } kEvents[] = {
+            { EV_ABS, ABS_MT_TRACKING_ID, 42 },
+            { EV_ABS, ABS_MT_POSITION_X, 360 },
+            { EV_ABS, ABS_MT_POSITION_Y, 640 },
+            { EV_SYN, SYN_REPORT, 0 },
+            { EV_ABS, ABS_MT_TRACKING_ID, -1 },
+            { EV_SYN, SYN_REPORT, 0 },
+        };
+        struct input_event ev[sizeof(kEvents) / sizeof(kEvents[0])];
+
+        memset(ev, 0, sizeof(ev));
+        for (size_t i = 0; i < sizeof(kEvents) / sizeof(kEvents[0]); i++) {
+            ev[i].type = kEvents[i].type;
+            ev[i].code = kEvents[i].code;
+            ev[i].value = kEvents[i].value;
+        }
+
+        ASSERT_EQ((ssize_t)sizeof(ev), write(touch_fd, ev, sizeof(ev)));
+    }
+
+    /* Wait for the HAL to read everything Touch() reported */
+    static void WaitForTouchRead()
+    {
+        ASSERT_TRUE(WaitFor([] {
+            int pending = 0;
+            return ioctl(touch_fd, FIONREAD, &pending) == 0 && !pending;
+        }));
+    }
+
+    /* ReadWrites(), once something was written from another thread */
+    static Writes WaitForWrites(int timeout_ms = 2000)
+    {
+        struct pollfd pfd = { watch_fd, POLLIN, 0 };
+
+        poll(&pfd, 1, timeout_ms);
+        return ReadWrites();
+    }
+
+    /* WaitForWrites() until node is among the writes, or timeout_ms */
+    static Writes WaitForWrite(const char *node, int timeout_ms = 2000)
+    {
+        struct timespec start, now;
+        Writes writes;
+        int left = timeout_ms;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        while (left > 0) {
+            for (const auto &w : WaitForWrites(left)) {
+                writes.push_back(w);
+                if (w.first == node)
+                    return writes;
+            }
+
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            left = timeout_ms - (int)((now.tv_sec - start.tv_sec) * 1000 +
+                    (now.tv_nsec - start.tv_nsec) / 1000000);
+        }
+
+        return writes;
+    }
+
+    static void Launch(int value)
+    {
+        int data = value;
+        module->powerHint(module, POWER_HINT_LAUNCH, value ? &data : NULL);
+    }
+
+    /* Let the boostpulse of an earlier hint run out, 40 ms when balanced */
+    static void WaitForBoostpulseEnd()
+    {
+        const struct timespec delay = { 0, 50000000 };
+        nanosleep(&delay, NULL);
+    }
+
+    /* Poll for done, for up to timeout_ms; returns whether it happened */
+    static bool WaitFor(const std::function<bool()> &done,
+                        int timeout_ms = 2000)
+    {
+        const struct timespec delay = { 0, 1000000 };
+
+        for (int i = 0; i < timeout_ms && !done(); i++)
+            nanosleep(&delay, NULL);
+
+        return done();
+    }
+
+    /* Switch governors, watching the new interactive directory if any */
+    static void SetGovernor(const char *governor)
+    {
+        ASSERT_EQ(0, fake_sysfs_set_governor(root, governor));
+        if (!strcmp(governor, "interactive"))
+            Watch(FAKE_INTERACTIVE_DIR);
+    }
+
+    /* Wait for the HAL to restore the tunables once more than restores */
+    static void WaitForRestore(unsigned long restores)
+    {
+        ASSERT_TRUE(WaitFor([=] {
+            return stats_counter(STATS_GOVERNOR_RESTORES) != restores;
+        })) << "tunables were never restored";
+    }
+
+    /* Switch the governor away and back, as a tuning app would */
+    static void RecreateGovernor()
+    {
+        unsigned long restores = stats_counter(STATS_GOVERNOR_RESTORES);
+
+        SetGovernor("performance");
+        SetGovernor("interactive");
+        WaitForRestore(restores);
+    }
+
+    /*
+     * Nodes written since the last call, with their content. The HAL
+     * rewrites nodes in place, so they are emptied again afterwards to
+     * keep a shorter value from showing the tail of the previous one.
+     */
+    static Writes ReadWrites()
+    {
+        char buf[sizeof(struct inotify_event) + NAME_MAX + 1];
+        char value[64];
+        Writes writes;
+        ssize_t len;
+
+        while ((len = read(watch_fd, buf, sizeof(buf))) > 0) {
+            for (char *p = buf; p < buf + len; ) {
+                struct inotify_event *event = (struct inotify_event *)p;
+                std::string node = WatchedDir(event->wd);
+
+                /* Such as IN_IGNORED, for a directory that went away */
+                p += sizeof(*event) + event->len;
+                if (!event->len)
+                    continue;
+
+                node += "/";
+                node += event->name;
+                fake_sysfs_read(root, node.c_str(), value, sizeof(value));
+                writes.push_back(Write(event->name, value));
+            }
+        }
+
+        fake_sysfs_clear(root);
+        while (read(watch_fd, buf, sizeof(buf)) > 0)
+            ;
+
+        return writes;
+    }
+
+    /* What every tunable holds, in the order the HAL writes them */
+    static Writes ReadTunables()
+    {
+        Writes tunables;
+        char value[64];
+
+        for (const auto &w : kBalancedWrites) {
+            std::string node = w.first.compare(0, 8, "scaling_") ?
+                    FAKE_INTERACTIVE_DIR : FAKE_CPUFREQ_LIMIT_DIR;
+
+            node += "/" + w.first;
+            fake_sysfs_read(root, node.c_str(), value, sizeof(value));
+            tunables.push_back(Write(w.first, value));
+        }
+
+        return tunables;
+    }
+
+    static Writes initial_writes;
+
+private:
+    static void Watch(const char *dir)
+    {
+        std::string path = std::string(root) + "/" + dir;
+        int wd = inotify_add_watch(watch_fd, path.c_str(), IN_MODIFY);
+
+        ASSERT_LE(0, wd);
+        watched.push_back(std::make_pair(wd, dir));
+    }
+
+    static std::string WatchedDir(int wd)
+    {
+        for (const auto &w : watched) {
+            if (w.first == wd)
+                return w.second;
+        }
+        return "";
+    }
+
+    static unsigned long CommitCount()
+    {
+        FILE *f = tmpfile();
+        unsigned long count = 0;
+        char line[128];
+
+        if (!f)
+            return 0;
+
+        stats_dump(fileno(f));
+        rewind(f);
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "commit.count=%lu", &count) == 1)
+                break;
+        }
+
+        fclose(f);
+        return count;
+    }
+
+    /*
+     * Make a request and wait for the worker thread to commit it. Requests
+     * are made one at a time, so the first commit after it includes it.
+     */
+    static void Commit(const std::function<void()> &request)
+    {
+        unsigned long count = CommitCount();
+        const struct timespec delay = { 0, 1000000 };
+
+        request();
+        for (int i = 0; i < 2000 && CommitCount() == count; i++)
+            nanosleep(&delay, NULL);
+
+        ASSERT_NE(count, CommitCount()) << "request was never committed";
+    }
+
+    static char root[PATH_MAX];
+    static int watch_fd;
+    static int touch_fd;
+    static std::vector<std::pair<int, std::string>> watched;
+    static struct power_module *module;
+};
+
+char PowerHalTest::root[PATH_MAX];
+int PowerHalTest::watch_fd = -1;
+int PowerHalTest::touch_fd = -1;
+std::vector<std::pair<int, std::string>> PowerHalTest::watched;
+struct power_module *PowerHalTest::module;
+Writes PowerHalTest::initial_writes;
+
+TEST_F(PowerHalTest, FirstProfileWritesEveryTunable)
+{
+    EXPECT_EQ(kBalancedWrites, initial_writes);
+}
+
+TEST_F(PowerHalTest, SameProfileWritesNothing)
+{
+    SetProfile(PROFILE_BALANCED);
+    EXPECT_EQ(Writes(), ReadWrites());
+}
+
+TEST_F(PowerHalTest, HighPerformanceRaisesFloor)
+{
+    SetProfile(PROFILE_HIGH_PERFORMANCE);
+    EXPECT_EQ(Writes({
+        { "boost", "1" },
+        { "scaling_min_freq", "1512000" },
+    }), ReadWrites());
+
+    SetProfile(PROFILE_BALANCED);
+    EXPECT_EQ(Writes({
+        { "boost", "0" },
+        { "scaling_min_freq", "384000" },
+    }), ReadWrites());
+}
+
+TEST_F(PowerHalTest, PowerSaveLowersCeiling)
+{
+    SetProfile(PROFILE_POWER_SAVE);
+    EXPECT_EQ(Writes({
+        { "scaling_max_freq", "1026000" },
+    }), ReadWrites());
+}
+
+TEST_F(PowerHalTest, ScreenOffSwitchesToOffTunables)
+{
+    SetInteractive(false);
+    EXPECT_EQ(Writes({
+        { "go_hispeed_load", "110" },
+        { "timer_rate", "50000" },
+        { "target_loads", "95 1512000:99" },
+    }), ReadWrites());
+
+    SetInteractive(true);
+    EXPECT_EQ(Writes({
+        { "go_hispeed_load", "90" },
+        { "timer_rate", "20000" },
+        { "target_loads", "85 1500000:90" },
+    }), ReadWrites());
+}
+
+TEST_F(PowerHalTest, VideoEncodeOverridesTimerRateAndIo)
+{
+    VideoEncode(true);
+    EXPECT_EQ(Writes({
+        { "timer_rate", "30000" },
+        { "io_is_busy", "0" },
+    }), ReadWrites());
+
+    VideoEncode(false);
+    EXPECT_EQ(Writes({
+        { "timer_rate", "20000" },
+        { "io_is_busy", "1" },
+    }), ReadWrites());
+}
+
+TEST_F(PowerHalTest, VideoEncodeWinsOverScreenOff)
+{
+    SetInteractive(false);
+    ReadWrites();
+
+    VideoEncode(true);
+    EXPECT_EQ(Writes({
+        { "timer_rate", "30000" },
+        { "io_is_busy", "0" },
+    }), ReadWrites());
+
+    SetInteractive(true);
+    EXPECT_EQ(Writes({
+        { "go_hispeed_load", "90" },
+        { "target_loads", "85 1500000:90" },
+    }), ReadWrites());
+}
+
+TEST_F(PowerHalTest, BoostpulseIsCoalesced)
+{
+    unsigned long coalesced = stats_counter(STATS_BOOSTPULSE_COALESCED);
+
+    WaitForBoostpulseEnd();
+    Interaction(0);
+    Interaction(0);
+    Interaction(0);
+    EXPECT_EQ(Writes({
+        { "boostpulse", "1" },
+    }), ReadWrites());
+    EXPECT_EQ(coalesced + 2, stats_counter(STATS_BOOSTPULSE_COALESCED));
+
+    WaitForBoostpulseEnd();
+    Interaction(0);
+    EXPECT_EQ(Writes({
+        { "boostpulse", "1" },
+    }), ReadWrites());
+}
+
+/*
+ * The boostpulse descriptor is never closed, a new governor directory gets
+ * its node duplicated over the old descriptor instead.
+ */
+TEST_F(PowerHalTest, BoostpulseFollowsRecreatedGovernor)
+{
+    WaitForBoostpulseEnd();
+    Interaction(0);
+    ReadWrites();
+
+    unsigned long reopens = stats_counter(STATS_BOOSTPULSE_REOPENS);
+    RecreateGovernor();
+    ReadWrites();
+    EXPECT_EQ(reopens + 1, stats_counter(STATS_BOOSTPULSE_REOPENS));
+
+    WaitForBoostpulseEnd();
+    Interaction(0);
+    EXPECT_EQ(Writes({
+        { "boostpulse", "1" },
+    }), ReadWrites());
+}
+
+/*
+ * The interactive directory comes back with the governor's defaults, the
+ * profile picked while it was away is what has to be restored.
+ */
+TEST_F(PowerHalTest, TunablesAreRestoredWhenGovernorReturns)
+{
+    SetGovernor("performance");
+    SetProfile(PROFILE_HIGH_PERFORMANCE);
+
+    unsigned long restores = stats_counter(STATS_GOVERNOR_RESTORES);
+    SetGovernor("interactive");
+    WaitForRestore(restores);
+
+    EXPECT_EQ(kHighPerformanceTunables, ReadTunables());
+    ReadWrites();
+}
+
+/* The last of duplicate keys wins, the strings it replaces are freed */
+TEST_F(PowerHalTest, ProfilesAreOverriddenFromConfig)
+{
+    SetProfile(PROFILE_BIAS_POWER_SAVE);
+    EXPECT_EQ(Writes({
+        { "hispeed_freq", "918000" },
+        { "above_hispeed_delay", "29000" },
+        { "target_loads", "70 1026000:85" },
+        { "scaling_max_freq", "1026000" },
+    }), ReadWrites());
+}
+
+/* Touches pulse from the input thread, at most once per 100 ms debounce */
+TEST_F(PowerHalTest, TouchBoostsAndIsDebounced)
+{
+    const struct timespec pulse_over = { 0, 60000000 };
+    const struct timespec debounce_over = { 0, 100000000 };
+    unsigned long boosts = stats_counter(STATS_INPUT_BOOSTS);
+
+    WaitForBoostpulseEnd();
+    Touch();
+    EXPECT_EQ(Writes({
+        { "boostpulse", "1" },
+    }), WaitForWrites());
+    EXPECT_EQ(boosts + 1, stats_counter(STATS_INPUT_BOOSTS));
+
+    /* Past the boostpulse, not past the debounce */
+    nanosleep(&pulse_over, NULL);
+    Touch();
+    WaitForTouchRead();
+    EXPECT_EQ(Writes(), WaitForWrites(20));
+    EXPECT_EQ(boosts + 1, stats_counter(STATS_INPUT_BOOSTS));
+
+    nanosleep(&debounce_over, NULL);
+    Touch();
+    EXPECT_EQ(Writes({
+        { "boostpulse", "1" },
+    }), WaitForWrites());
+    EXPECT_EQ(boosts + 2, stats_counter(STATS_INPUT_BOOSTS));
+}
+
+/* Longer than the boostpulse, the floor is held at hispeed_freq */
+TEST_F(PowerHalTest, BoostWindowHoldsFloorUntilItEnds)
+{
+    WaitForBoostpulseEnd();
+    Interaction(300);
+    EXPECT_EQ(Writes({
+        { "boostpulse", "1" },
+        { "scaling_min_freq", "1134000" },
+    }), WaitForWrite("scaling_min_freq"));
+
+    EXPECT_EQ(Writes({
+        { "scaling_min_freq", "384000" },
+    }), WaitForWrite("scaling_min_freq"));
+}
+
+/* A request ending within the window in effect is folded into it */
+TEST_F(PowerHalTest, ShorterBoostIsMergedIntoWindow)
+{
+    unsigned long windows = stats_counter(STATS_BOOST_WINDOWS);
+    unsigned long merged = stats_counter(STATS_BOOST_WINDOWS_MERGED);
+
+    WaitForBoostpulseEnd();
+    Interaction(500);
+    EXPECT_EQ(Writes({
+        { "boostpulse", "1" },
+        { "scaling_min_freq", "1134000" },
+    }), WaitForWrite("scaling_min_freq"));
+
+    Interaction(100);
+    EXPECT_EQ(windows + 1, stats_counter(STATS_BOOST_WINDOWS));
+    EXPECT_EQ(merged + 1, stats_counter(STATS_BOOST_WINDOWS_MERGED));
+
+    /* Nothing but maybe a pulse until the first window ends */
+    Writes writes = WaitForWrite("scaling_min_freq");
+    EXPECT_EQ(Write("scaling_min_freq", "384000"), writes.back());
+    writes.pop_back();
+    for (const auto &w : writes)
+        EXPECT_EQ("boostpulse", w.first);
+}
+
+/* LAUNCH holds the maximum until it is sent again without data */
+TEST_F(PowerHalTest, LaunchHoldsMaxUntilEnded)
+{
+    WaitForBoostpulseEnd();
+    Launch(1);
+    EXPECT_EQ(Writes({
+        { "boostpulse", "1" },
+        { "scaling_min_freq", "1512000" },
+    }), WaitForWrite("scaling_min_freq"));
+
+    Launch(0);
+    EXPECT_EQ(Writes({
+        { "scaling_min_freq", "384000" },
+    }), WaitForWrite("scaling_min_freq"));
+}
+
+/* However long the request, the floor drops after the longest window */
+TEST_F(PowerHalTest, BoostWindowIsClamped)
+{
+    struct timespec start, end;
+
+    WaitForBoostpulseEnd();
+    Interaction(60000);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    EXPECT_EQ(Writes({
+        { "boostpulse", "1" },
+        { "scaling_min_freq", "1134000" },
+    }), WaitForWrite("scaling_min_freq"));
+
+    EXPECT_EQ(Writes({
+        { "scaling_min_freq", "384000" },
+    }), WaitForWrite("scaling_min_freq", kBoostMaxMs * 2));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    long ms = (end.tv_sec - start.tv_sec) * 1000 +
+            (end.tv_nsec - start.tv_nsec) / 1000000;
+    EXPECT_LE(kBoostMaxMs - 100, ms);
+    EXPECT_GT(kBoostMaxMs * 2, ms);
+}
+
+/* A boost only moves the floor, video encode keeps its io_is_busy */
+TEST_F(PowerHalTest, BoostKeepsVideoEncodeIo)
+{
+    VideoEncode(true);
+    ReadWrites();
+
+    WaitForBoostpulseEnd();
+    Interaction(300);
+    EXPECT_EQ(Writes({
+        { "boostpulse", "1" },
+        { "scaling_min_freq", "1134000" },
+    }), WaitForWrite("scaling_min_freq"));
+
+    EXPECT_EQ(Writes({
+        { "scaling_min_freq", "384000" },
+    }), WaitForWrite("scaling_min_freq"));
+}
+
+static const int32_t kModeOn = 1;
+static const int32_t kModeOff = 0;
+
+/* Balanced to sustained performance, held at the plateau's start */
+static const Writes kSustainedWrites = {
+    { "boostpulse_duration", "0" },
+    { "above_hispeed_delay", "19000" },
+    { "min_sample_time", "79000" },
+    { "target_loads", "80" },
+    { "scaling_min_freq", "594000" },
+    { "scaling_max_freq", "1134000" },
+};
+
+/* Sustained performance to low power */
+static const Writes kSustainedToLowPowerWrites = {
+    { "go_hispeed_load", "99" },
+    { "hispeed_freq", "810000" },
+    { "above_hispeed_delay", "39000" },
+    { "timer_rate", "40000" },
+    { "io_is_busy", "0" },
+    { "min_sample_time", "39000" },
+    { "max_freq_hysteresis", "0" },
+    { "target_loads", "90" },
+    { "scaling_min_freq", "384000" },
+    { "scaling_max_freq", "918000" },
+};
+
+/* And back */
+static const Writes kLowPowerToSustainedWrites = {
+    { "go_hispeed_load", "90" },
+    { "hispeed_freq", "1134000" },
+    { "above_hispeed_delay", "19000" },
+    { "timer_rate", "20000" },
+    { "io_is_busy", "1" },
+    { "min_sample_time", "79000" },
+    { "max_freq_hysteresis", "99000" },
+    { "target_loads", "80" },
+    { "scaling_min_freq", "594000" },
+    { "scaling_max_freq", "1134000" },
+};
+
+/* Battery saver is the user's choice, it wins over an app's request */
+TEST_F(PowerHalTest, LowPowerWinsOverSustained)
+{
+    SetMode(POWER_HINT_SUSTAINED_PERFORMANCE, &kModeOn);
+    EXPECT_EQ(kSustainedWrites, ReadWrites());
+
+    SetMode(POWER_HINT_LOW_POWER, &kModeOn);
+    EXPECT_EQ(kSustainedToLowPowerWrites, ReadWrites());
+
+    SetMode(POWER_HINT_LOW_POWER, &kModeOff);
+    EXPECT_EQ(kLowPowerToSustainedWrites, ReadWrites());
+
+    SetMode(POWER_HINT_SUSTAINED_PERFORMANCE, &kModeOff);
+    EXPECT_EQ(Writes({
+        { "boostpulse_duration", "40000" },
+        { "above_hispeed_delay", "19000 1400000:39000" },
+        { "min_sample_time", "39000" },
+        { "target_loads", "85 1500000:90" },
+        { "scaling_min_freq", "384000" },
+        { "scaling_max_freq", "1512000" },
+    }), ReadWrites());
+}
+
+/*
+ * A profile picked while a mode is on is recorded, and is what applies
+ * once the mode is left, with data 0 or none.
+ */
+TEST_F(PowerHalTest, ModesWinOverProfile)
+{
+    SetMode(POWER_HINT_SUSTAINED_PERFORMANCE, &kModeOn);
+    ReadWrites();
+
+    SetProfile(PROFILE_HIGH_PERFORMANCE);
+    EXPECT_EQ(Writes(), ReadWrites());
+
+    SetMode(POWER_HINT_SUSTAINED_PERFORMANCE, NULL);
+    EXPECT_EQ(Writes({
+        { "boost", "1" },
+        { "boostpulse_duration", "40000" },
+        { "above_hispeed_delay", "19000 1400000:39000" },
+        { "min_sample_time", "39000" },
+        { "target_loads", "85 1500000:90" },
+        { "scaling_min_freq", "1512000" },
+        { "scaling_max_freq", "1512000" },
+    }), ReadWrites());
+
+    SetMode(POWER_HINT_LOW_POWER, &kModeOn);
+    ReadWrites();
+    SetProfile(PROFILE_BALANCED);
+    EXPECT_EQ(Writes(), ReadWrites());
+
+    SetMode(POWER_HINT_LOW_POWER, &kModeOff);
+    EXPECT_EQ(Writes({
+        { "boostpulse_duration", "40000" },
+        { "go_hispeed_load", "90" },
+        { "hispeed_freq", "1134000" },
+        { "above_hispeed_delay", "19000 1400000:39000" },
+        { "timer_rate", "20000" },
+        { "io_is_busy", "1" },
+        { "max_freq_hysteresis", "99000" },
+        { "target_loads", "85 1500000:90" },
+        { "scaling_max_freq", "1512000" },
+    }), ReadWrites());
+}
+
+/* Boosts are ignored while a mode holds the tunables */
+TEST_F(PowerHalTest, ModesAreNotBoosted)
+{
+    unsigned long windows = stats_counter(STATS_BOOST_WINDOWS);
+
+    SetMode(POWER_HINT_LOW_POWER, &kModeOn);
+    ReadWrites();
+
+    WaitForBoostpulseEnd();
+    Interaction(300);
+    Launch(1);
+    EXPECT_EQ(windows, stats_counter(STATS_BOOST_WINDOWS));
+
+    SetMode(POWER_HINT_LOW_POWER, &kModeOff);
+    ReadWrites();
+}